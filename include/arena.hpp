@@ -0,0 +1,27 @@
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <memory_resource>
+
+/*
+ * The memory of a single compilation. Containers of the IR allocate from the arena
+ * through std::pmr allocators: memory is taken from large chunks that are only given
+ * back (all at once) when the arena is destroyed, while freed blocks are pooled by
+ * size so that containers that grow and shrink reuse them.
+ */
+class Arena {
+public:
+    Arena();
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    /*
+     * @return The memory resource containers should allocate from.
+     */
+    std::pmr::memory_resource* resource();
+private:
+    std::pmr::monotonic_buffer_resource chunks;
+    std::pmr::unsynchronized_pool_resource pools;
+};
+
+#endif // ARENA_HPP
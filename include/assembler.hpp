@@ -90,6 +90,7 @@ private:
     std::ifstream infile;
     std::unordered_map<std::string, size_t> sym_table;
     size_t curr_offset{};
+    std::vector<uint8_t> data;
     std::vector<uint8_t> program_bytecode;
 };
 
@@ -1,7 +1,9 @@
 #ifndef BASICBLOCK_HPP
 #define BASICBLOCK_HPP
 
-#include "instruction.hpp"
+#include "identifiermap.hpp"
+#include "instructionlist.hpp"
+#include <memory_resource>
 #include <vector>
 
 enum Blocktype {
@@ -18,16 +20,14 @@ enum Blocktype {
 using ident_t = ssize_t;
 using bb_t = ssize_t;
 struct BasicBlock {
-    std::vector<Instruction> instructions;
-    std::vector<std::vector<int>> partitioned_instructions;
-    int empty_index = -1; // When an EMPTY instruction is added, this is changed to its index in the instructions vector.
-                         // That way, when it's updated, its index can be added to partitioned_instructions if its CSE-able.
+    using allocator_type = std::pmr::polymorphic_allocator<>; // Blocks allocate from the allocator of the vector holding them.
+    InstructionList instructions;
     Blocktype type;
     bool will_return = false; // If the block is guaranteed to return, this'll be true.
     bb_t index;
-    std::vector<bb_t> predecessors;
-    std::vector<bb_t> successors;
-    std::vector<instruct_t> identifier_values;
+    std::pmr::vector<bb_t> predecessors;
+    std::pmr::vector<bb_t> successors;
+    IdentifierMap identifier_values; // Shared with the block it was copied from until either changes.
     Instruction branch_instruction{-1, EMPTY, -1, -1};
     bb_t branch_block = -1; // If not -1, this is a while loop header
     bb_t loop_header = -1; // If not -1. this is a branch-back block
@@ -35,15 +35,19 @@ struct BasicBlock {
     bool analyzed = false; // Are you liveness analyzed?
     bool propagated = false; // Have you had phis propagated to you already?
     bool emitted = false; // Have you been emitted as code yet?
-    BasicBlock(const bb_t& i);
-    BasicBlock(const bb_t& i, const ident_t& ident_count, const bb_t& p); 
-    BasicBlock(const bb_t& i, const std::vector<instruct_t>& dom_ident_vals, const bb_t& p);              
-    BasicBlock(const bb_t& i, const std::vector<instruct_t>& dom_ident_vals, const bb_t& p, Blocktype t); 
-    BasicBlock(const bb_t& i, const bb_t& p1, const bb_t& p2, Blocktype t);
+    BasicBlock(const bb_t& i, const allocator_type& alloc = {});
+    BasicBlock(const bb_t& i, const ident_t& ident_count, const bb_t& p, const allocator_type& alloc = {}); 
+    BasicBlock(const bb_t& i, const IdentifierMap& dom_ident_vals, const bb_t& p, const allocator_type& alloc = {});              
+    BasicBlock(const bb_t& i, const IdentifierMap& dom_ident_vals, const bb_t& p, Blocktype t, const allocator_type& alloc = {}); 
+    BasicBlock(const bb_t& i, const IdentifierMap& dom_ident_vals, const bb_t& p1, const bb_t& p2, Blocktype t, const allocator_type& alloc = {});
+    BasicBlock(const BasicBlock& other, const allocator_type& alloc);
+    BasicBlock(BasicBlock&& other, const allocator_type& alloc);
+    BasicBlock(const BasicBlock& other) = default;
+    BasicBlock(BasicBlock&& other) = default;
+    BasicBlock& operator=(const BasicBlock& other) = default;
+    BasicBlock& operator=(BasicBlock&& other) = default;
     void add_instruction(const instruct_t& num, Opcode op, const instruct_t& x1, const instruct_t& x2);
     void prepend_instruction(const instruct_t& num, Opcode op, const instruct_t& x1, const instruct_t& x2);
-    void add_instruction(const instruct_t& num, Opcode op, const instruct_t& x1, const instruct_t& x2, const ident_t& x1_owner, const ident_t& x2_owner);
-    void prepend_instruction(const instruct_t& num, Opcode op, const instruct_t& x1, const instruct_t& x2, const ident_t& x1_owner, const ident_t& x2_owner);
     instruct_t get_ident_value(const ident_t& ident);
     void change_instruction(const ident_t& ident, const instruct_t& instruct);
     std::string to_dotlang() const;
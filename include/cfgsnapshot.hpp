@@ -0,0 +1,55 @@
+#ifndef CFGSNAPSHOT_HPP
+#define CFGSNAPSHOT_HPP
+
+#include "basicblock.hpp"
+#include <span>
+#include <vector>
+
+/*
+ * An immutable copy of the CFG's edges in compressed sparse row form: the predecessors
+ * (or successors) of every block are stored back to back in one flat array, with an
+ * offset array marking where each block's edges start. Preorder, postorder and reverse
+ * postorder of the blocks reachable from the const block are computed along with it.
+ *
+ * Like the basic blocks themselves, the snapshot doesn't record back edges, so the graph
+ * it describes is acyclic: a block's successors always come before it in postorder.
+ */
+class CFGSnapshot {
+public:
+    /*
+     * Takes a snapshot of the edges of the given basic blocks.
+     *
+     * @param basic_blocks The IR's basic blocks.
+     */
+    CFGSnapshot(const std::pmr::vector<BasicBlock>& basic_blocks);
+
+    std::span<const bb_t> get_predecessors(const bb_t& b) const;
+    std::span<const bb_t> get_successors(const bb_t& b) const;
+
+    /*
+     * @return The blocks reachable from the const block in the order a depth first search first visits them.
+     */
+    const std::vector<bb_t>& get_preorder() const;
+
+    /*
+     * @return The blocks reachable from the const block, every block coming after all of its successors.
+     */
+    const std::vector<bb_t>& get_postorder() const;
+
+    /*
+     * @return The blocks reachable from the const block, every block coming before all of its successors.
+     */
+    const std::vector<bb_t>& get_reverse_postorder() const;
+
+    size_t size() const;
+private:
+    std::vector<size_t> predecessor_offsets;
+    std::vector<bb_t> predecessor_edges;
+    std::vector<size_t> successor_offsets;
+    std::vector<bb_t> successor_edges;
+    std::vector<bb_t> preorder;
+    std::vector<bb_t> postorder;
+    std::vector<bb_t> reverse_postorder;
+};
+
+#endif // CFGSNAPSHOT_HPP
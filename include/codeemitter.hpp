@@ -11,8 +11,12 @@ public:
     void emit_code();
     void debug() const;
 private:
+    static constexpr int MEMO_ENTRIES = 1024; // Entries of a memo table (a filled flag and a result each).
+    static constexpr int MEMO_COLUMNS = 32;   // Values of the second argument a memo table has room for.
+
     bool getting_pars = false;
     bool main = false;
+    bb_t function_entry = -1; // The entry block of the function being emitted.
     /* Code Emitting */
     // Several //
     std::string block(const bb_t& b);
@@ -27,6 +31,54 @@ private:
     std::string additive(const Instruction& i, const std::string& operand);
     std::string cmp(const Instruction& i);
 
+    /* Memoization */
+    /*
+     * A memoized function's arguments index its memo table if they fit: a single argument in
+     * [0, MEMO_ENTRIES), or two in [0, MEMO_ENTRIES / MEMO_COLUMNS) and [0, MEMO_COLUMNS). The table
+     * is probed once the function's frame is set up, and a filled entry returns its result right
+     * away. Otherwise the entry's address (or 0 if the arguments don't fit) is pushed for the
+     * returns to fill in.
+     *
+     * @return The emitted code.
+     */
+    std::string memo_probe();
+
+    /*
+     * Fills in the memo table entry pushed by the probe (if there's one) before a memoized function returns.
+     *
+     * @param ret The return instruction.
+     * @return The emitted code.
+     */
+    std::string memo_store(const Instruction& ret);
+
+    /* Loop Rotation */
+    /*
+     * A rotated loop repeats its header's test at the bottom of the loop, so an iteration
+     * runs a single conditional branch back to the top of the body instead of an unconditional
+     * branch to the header followed by the header's test. The header's test only guards the
+     * first entry into the loop.
+     *
+     * @param loop_header The loop's header.
+     * @return true if the given loop is rotated.
+     */
+    bool rotates(const bb_t& loop_header);
+
+    /*
+     * Emits the bottom test of a rotated loop in place of the branch back to its header. The
+     * header's instructions are repeated after the branch back block's phi copies, which is what
+     * branching back to the header would run, followed by the inverted branch to the loop's body.
+     *
+     * @param branch_back The rotated loop's branch back block.
+     * @return The emitted code.
+     */
+    std::string rotated_test(const bb_t& branch_back);
+
+    /*
+     * @param opcode The given conditional branch opcode.
+     * @return The jump taken when the given branch isn't.
+     */
+    std::string inverted_jump(const Opcode& opcode);
+
     /* Instructions */
     std::string mov_instruction(const instruct_t& from, const instruct_t& to);
     std::string additive_instruction(const instruct_t& left, const instruct_t& right, const std::string& operand);
@@ -0,0 +1,111 @@
+#ifndef CONSTANTPROPAGATION_HPP
+#define CONSTANTPROPAGATION_HPP
+
+#include "basicblock.hpp"
+#include <cstdint>
+#include <memory_resource>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * What's known about an instruction's value: nothing yet (its block may never run),
+ * a single constant, or that it can take more than one value.
+ */
+struct LatticeValue {
+    enum State : std::uint8_t { UNDEFINED, CONSTANT, OVERDEFINED };
+    State state = UNDEFINED;
+    int value = 0;
+
+    bool operator==(const LatticeValue& other) const = default;
+};
+
+/*
+ * Sparse conditional constant propagation (Wegman and Zadeck). Starting from the const block,
+ * only CFG edges that can be taken are followed: a conditional branch whose comparison is
+ * constant only marks one of its successors executable. Instruction values are propagated
+ * along their uses, and phi functions only take values from executable incoming edges. The
+ * result is the constant value of every instruction that always computes the same value, and
+ * the blocks that can run at all.
+ *
+ * Back edges are followed through the branch instructions of branch back blocks, so a loop's
+ * phi functions see the values coming around the loop once its body is known to run.
+ */
+class ConstantPropagation {
+public:
+    /*
+     * Runs the analysis over the given basic blocks.
+     *
+     * @param basic_blocks The IR's basic blocks.
+     * @param const_instructions The values of the const block's instructions.
+     * @param instruction_count The highest instruction number in use.
+     */
+    ConstantPropagation(const std::pmr::vector<BasicBlock>& basic_blocks, const std::pmr::unordered_map<instruct_t, int>& const_instructions, const instruct_t& instruction_count);
+
+    /*
+     * @param instruct The given instruction.
+     * @return What's known about the instruction's value.
+     */
+    const LatticeValue& get(const instruct_t& instruct) const;
+
+    /*
+     * @param b The given block's index.
+     * @return true if the given block can run.
+     */
+    bool is_executable(const bb_t& b) const;
+
+    /*
+     * @param from The edge's source block.
+     * @param to The edge's destination block.
+     * @return true if control can flow along the given edge.
+     */
+    bool is_executable(const bb_t& from, const bb_t& to) const;
+
+    /*
+     * @param b The given block's index.
+     * @return The block the given block's branch instruction branches to, or -1 if it doesn't branch.
+     */
+    bb_t get_branch_target(const bb_t& b) const;
+
+    /*
+     * @param b The given block's index (a join block or a loop header).
+     * @return The blocks the left and right arguments of the given block's phi functions come from.
+     */
+    std::pair<bb_t, bb_t> get_phi_predecessors(const bb_t& b) const;
+
+    /*
+     * @param op The given arithmetic opcode.
+     * @param larg The left argument's value.
+     * @param rarg The right argument's value.
+     * @return The result as a constant, or an overdefined value if it can't be computed at compile time.
+     */
+    static LatticeValue fold(Opcode op, const int& larg, const int& rarg);
+
+    /*
+     * @param op The given conditional branch opcode.
+     * @param larg The compared left value.
+     * @param rarg The compared right value.
+     * @return true if the branch is taken.
+     */
+    static bool is_taken(Opcode op, const int& larg, const int& rarg);
+private:
+    const std::pmr::vector<BasicBlock>& basic_blocks;
+    std::vector<LatticeValue> values;
+    std::vector<const Instruction*> definitions;
+    std::vector<bb_t> definition_blocks;
+    std::vector<std::vector<instruct_t>> uses;
+    std::unordered_map<instruct_t, bb_t> labels; // Maps a block's first instruction to the block.
+    std::vector<bool> executable_blocks;
+    std::set<std::pair<bb_t, bb_t>> executable_edges;
+    std::vector<std::pair<bb_t, bb_t>> flow_worklist;
+    std::vector<instruct_t> ssa_worklist;
+
+    LatticeValue argument(const instruct_t& instruct) const;
+    void visit(const Instruction& instruction, const bb_t& b);
+    void visit_branch(const Instruction& branch_instruction, const bb_t& b);
+    void visit_block(const bb_t& b);
+    void mark_edge(const bb_t& from, const bb_t& to);
+    void lower(const instruct_t& instruct, const LatticeValue& value);
+};
+
+#endif // CONSTANTPROPAGATION_HPP
@@ -0,0 +1,125 @@
+#ifndef DOMINATORTREE_HPP
+#define DOMINATORTREE_HPP
+
+#include "basicblock.hpp"
+#include <vector>
+
+/*
+ * The dominator tree of the CFG, rooted at the const block. Besides each block's
+ * immediate dominator, the tree keeps child lists and depths up to date as blocks are
+ * added or moved. Preorder and postorder numbers of a DFS over the tree are recomputed
+ * lazily the first time they're needed after a change, after which dominance queries
+ * are constant time.
+ */
+class DominatorTree {
+public:
+    /*
+     * Creates a tree that only contains the const block.
+     */
+    DominatorTree();
+
+    /*
+     * Recomputes the tree from scratch using the Cooper-Harvey-Kennedy algorithm, visiting
+     * blocks in reverse postorder. A loop header's branch back block is treated as one of
+     * its predecessors. Blocks that can't be reached from the const block are left
+     * without an immediate dominator.
+     *
+     * @param basic_blocks The IR's basic blocks.
+     */
+    void compute(const std::pmr::vector<BasicBlock>& basic_blocks);
+
+    /*
+     * Adds a new leaf to the tree.
+     *
+     * @param b The new block's index.
+     * @param idom The new block's immediate dominator.
+     */
+    void add_block(const bb_t& b, const bb_t& idom);
+
+    /*
+     * Moves the given block, along with every block it dominates, under a new immediate dominator.
+     *
+     * @param b The given block's index.
+     * @param idom The given block's new immediate dominator.
+     */
+    void set_idom(const bb_t& b, const bb_t& idom);
+
+    /*
+     * Makes room for new blocks by moving every block from the given position onwards up by the
+     * given amount. The new blocks are left out of the tree.
+     *
+     * @param position The index of the first moved block.
+     * @param count The amount of blocks inserted.
+     */
+    void insert_blocks(const bb_t& position, const size_t& count);
+
+    /*
+     * Updates the tree after the given block was split in two, the second half (tail)
+     * being a new block that took over the given block's successors.
+     *
+     * @param b The index of the block that was split.
+     * @param tail The index of the new block.
+     */
+    void split_block(const bb_t& b, const bb_t& tail);
+
+    /*
+     * Updates the tree after the given block was merged into its immediate dominator,
+     * which takes over the blocks the given block dominated.
+     *
+     * @param b The index of the block that was merged away.
+     */
+    void merge_block(const bb_t& b);
+
+    /*
+     * Finds the closest dominator the two given blocks have in common.
+     *
+     * @param b1 The first block's index.
+     * @param b2 The second block's index.
+     * @return The nearest common dominator of the two blocks.
+     */
+    bb_t intersect(bb_t b1, bb_t b2) const;
+
+    /*
+     * @param a The possible dominator's index.
+     * @param b The given block's index.
+     * @return true if every path from the const block to b passes through a (a block dominates itself).
+     */
+    bool dominates(const bb_t& a, const bb_t& b) const;
+
+    /*
+     * @param a The possible dominator's index.
+     * @param b The given block's index.
+     * @return true if a dominates b and isn't b.
+     */
+    bool strictly_dominates(const bb_t& a, const bb_t& b) const;
+
+    /*
+     * Computes the dominance frontier of every block: the blocks where a block's dominance ends.
+     *
+     * @param basic_blocks The IR's basic blocks (the CFG the tree belongs to).
+     * @return The dominance frontier of every block, indexed by block.
+     */
+    std::vector<std::vector<bb_t>> dominance_frontiers(const std::pmr::vector<BasicBlock>& basic_blocks) const;
+
+    const bb_t& get_idom(const bb_t& b) const;
+    const std::vector<bb_t>& get_children(const bb_t& b) const;
+    size_t get_depth(const bb_t& b) const;
+    size_t size() const;
+private:
+    std::vector<bb_t> idoms;
+    std::vector<std::vector<bb_t>> children;
+    std::vector<size_t> depths;
+
+    /* DFS numbering (recomputed lazily) */
+    mutable bool numbered = false;
+    mutable std::vector<size_t> preorder;
+    mutable std::vector<size_t> postorder;
+    void number() const;
+
+    /* Helpers */
+    void grow(const bb_t& b);
+    void detach(const bb_t& b);
+    void attach(const bb_t& b, const bb_t& idom);
+};
+
+#endif // DOMINATORTREE_HPP
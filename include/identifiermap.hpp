@@ -0,0 +1,111 @@
+#ifndef IDENTIFIERMAP_HPP
+#define IDENTIFIERMAP_HPP
+
+#include "instruction.hpp"
+#include <array>
+#include <memory>
+#include <memory_resource>
+
+/*
+ * A persistent map from identifiers to their current values, stored as a path copying
+ * radix tree. Copying a map is constant time since the copy shares every node with the
+ * original; changing a value afterwards only copies the nodes on the path to it. Nodes
+ * that aren't shared are changed in place.
+ *
+ * Identifiers that were never given a value read as a fill value, an arithmetic sequence
+ * (fill - ident * fill_step), so that a map can start with a distinct value for every
+ * identifier without storing any of them.
+ */
+class IdentifierMap {
+public:
+    /*
+     * Creates a map with no identifiers.
+     */
+    IdentifierMap();
+
+    /*
+     * Creates a map for the given amount of identifiers, each reading as its fill value.
+     *
+     * @param size The amount of identifiers.
+     * @param fill The value of identifier 0.
+     * @param fill_step How much smaller each following identifier's value is.
+     * @param resource The memory resource the map's nodes are allocated from.
+     */
+    explicit IdentifierMap(const ident_t& size, const instruct_t& fill = 0, const instruct_t& fill_step = 0, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    /*
+     * @param ident The given identifier.
+     * @return The given identifier's value, or -1 if the map doesn't contain it.
+     */
+    instruct_t get(const ident_t& ident) const;
+
+    /*
+     * Changes the value of the given identifier, which must be in the map.
+     *
+     * @param ident The given identifier.
+     * @param value The identifier's new value.
+     */
+    void set(const ident_t& ident, const instruct_t& value);
+
+    /*
+     * Calls the given function for every identifier whose value differs between this map
+     * and the other map (which must be the same size). Subtrees the two maps share are
+     * skipped, so comparing a map to one it was copied from is proportional to the amount
+     * of values changed since.
+     *
+     * @param other The other map.
+     * @param f Called with the identifier, its value in this map and its value in the other map.
+     */
+    template<typename F>
+    void for_each_difference(const IdentifierMap& other, F f) const {
+        diff_branch(root.get(), other, other.root.get(), height, 0, f);
+    }
+
+    ident_t size() const;
+private:
+    static constexpr ident_t BITS = 4;
+    static constexpr ident_t WIDTH = 1 << BITS;
+    static constexpr ident_t MASK = WIDTH - 1;
+    struct Leaf {
+        std::array<instruct_t, WIDTH> values;
+    };
+    struct Branch {
+        std::array<std::shared_ptr<Branch>, WIDTH> branches; // Used above the lowest level.
+        std::array<std::shared_ptr<Leaf>, WIDTH> leaves; // Used at the lowest level.
+    };
+
+    ident_t identifier_count = 0;
+    ident_t height = 1; // Amount of branch levels above the leaves.
+    instruct_t fill = 0;
+    instruct_t fill_step = 0;
+    std::shared_ptr<Branch> root;
+    std::pmr::memory_resource* resource = std::pmr::get_default_resource(); // Shared by every copy of the map.
+
+    instruct_t fill_value(const ident_t& ident) const;
+
+    template<typename F>
+    void diff_branch(const Branch* branch, const IdentifierMap& other, const Branch* other_branch, const ident_t& level, const ident_t& base, F& f) const {
+        if(branch == other_branch && fill == other.fill && fill_step == other.fill_step) return;
+        const ident_t span = static_cast<ident_t>(1) << (BITS * level);
+        for(ident_t i = 0; i < WIDTH && base + i * span < identifier_count; ++i) {
+            const ident_t child_base = base + i * span;
+            if(level > 1) {
+                diff_branch(branch ? branch->branches[i].get() : nullptr, other, other_branch ? other_branch->branches[i].get() : nullptr, level - 1, child_base, f);
+            } else {
+                diff_leaf(branch ? branch->leaves[i].get() : nullptr, other, other_branch ? other_branch->leaves[i].get() : nullptr, child_base, f);
+            }
+        }
+    }
+
+    template<typename F>
+    void diff_leaf(const Leaf* leaf, const IdentifierMap& other, const Leaf* other_leaf, const ident_t& base, F& f) const {
+        if(leaf == other_leaf && fill == other.fill && fill_step == other.fill_step) return;
+        for(ident_t i = 0; i < WIDTH && base + i < identifier_count; ++i) {
+            const instruct_t value = leaf ? leaf->values[i] : fill_value(base + i);
+            const instruct_t other_value = other_leaf ? other_leaf->values[i] : other.fill_value(base + i);
+            if(value != other_value) f(base + i, value, other_value);
+        }
+    }
+};
+
+#endif // IDENTIFIERMAP_HPP
@@ -0,0 +1,65 @@
+#ifndef INDUCTIONVARIABLES_HPP
+#define INDUCTIONVARIABLES_HPP
+
+#include "basicblock.hpp"
+#include "loopforest.hpp"
+#include <memory_resource>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/*
+ * A basic induction variable of a loop: a phi function of the loop's header whose value
+ * coming around the back edge is the phi function plus (or minus) a constant.
+ */
+struct InductionVariable {
+    instruct_t phi;
+    instruct_t init;       // The value entering the loop (the phi function's left argument).
+    instruct_t increment;  // The value coming around the back edge (the phi function's right argument).
+    bb_t increment_block;  // The block the increment is defined in.
+    int step;              // The amount the variable changes by every iteration.
+};
+
+/*
+ * A derived induction variable: a loop-invariant factor times a basic induction variable.
+ * It changes by factor * step every iteration, so it can be carried in a phi function of its
+ * own instead of being multiplied out every iteration.
+ */
+struct DerivedInductionVariable {
+    size_t basic;                         // The basic induction variable's index.
+    instruct_t factor;
+    std::vector<instruct_t> phi_products;       // Multiplies computing factor * phi.
+    std::vector<instruct_t> increment_products; // Multiplies computing factor * increment.
+};
+
+/*
+ * Finds the induction variables of a loop. Basic induction variables are the loop header's
+ * phi functions that step by a constant every iteration. Derived induction variables are the
+ * multiplies in the loop (including its nested loops) of a basic induction variable, or its
+ * increment, by a value that doesn't change in the loop. Multiplies by the same factor are
+ * the same derived induction variable.
+ */
+class InductionVariables {
+public:
+    /*
+     * @param basic_blocks The IR's basic blocks.
+     * @param const_instructions The values of the const block's instructions.
+     * @param loop The given loop.
+     */
+    InductionVariables(const std::pmr::vector<BasicBlock>& basic_blocks, const std::pmr::unordered_map<instruct_t, int>& const_instructions, const Loop& loop);
+
+    const std::vector<InductionVariable>& get_basic() const;
+    const std::vector<DerivedInductionVariable>& get_derived() const;
+
+    /*
+     * @param instruct The given instruction.
+     * @return true if the given instruction is defined outside of the loop.
+     */
+    bool is_invariant(const instruct_t& instruct) const;
+private:
+    std::vector<InductionVariable> basic;
+    std::vector<DerivedInductionVariable> derived;
+    std::unordered_set<instruct_t> variants; // The instructions defined in the loop.
+};
+
+#endif // INDUCTIONVARIABLES_HPP
@@ -2,19 +2,21 @@
 #define INSTRUCTION_HPP
 
 #include "opcode.hpp"
+#include <cstdint>
 
 using ident_t = ssize_t;
-using instruct_t = ssize_t;
+using instruct_t = std::int32_t;
+// Instructions are kept small so that scanning a block touches as few cache lines as possible.
+// Anything only needed while constructing the IR (such as which identifier a phi function
+// belongs to) is kept in side tables by the IntermediateRepresentation instead.
 struct Instruction {
     instruct_t instruction_number;
-    Opcode opcode;
     instruct_t larg;
     instruct_t rarg;
-    ident_t larg_owner = -1;
-    ident_t rarg_owner = -1;
+    Opcode opcode;
     Instruction(const instruct_t& num, Opcode op, const instruct_t& x1, const instruct_t& x2);
-    Instruction(const instruct_t& num, Opcode op, const instruct_t& x1, const instruct_t& x2, const ident_t& x1_owner, const ident_t& x2_owner); 
     std::string to_dotlang() const;
 };
+static_assert(sizeof(Instruction) == 16);
 
 #endif // INSTRUCTION_HPP
@@ -0,0 +1,124 @@
+#ifndef INSTRUCTIONLIST_HPP
+#define INSTRUCTIONLIST_HPP
+
+#include "instruction.hpp"
+#include <cstddef>
+#include <iterator>
+#include <memory_resource>
+#include <vector>
+
+/*
+ * The instructions of a basic block, stored as a doubly linked list over an arena of nodes.
+ * Inserting or removing an instruction anywhere in the list is constant time. Every
+ * instruction has a handle (its node's index in the arena) that stays valid until the
+ * instruction is removed, after which the node is reused by the next insertion.
+ */
+class InstructionList {
+    struct Node {
+        Instruction instruction;
+        std::int32_t prev;
+        std::int32_t next;
+    };
+public:
+    using handle_t = std::int32_t;
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    InstructionList(const allocator_type& alloc = {});
+    InstructionList(const InstructionList& other, const allocator_type& alloc);
+    InstructionList(InstructionList&& other, const allocator_type& alloc);
+    InstructionList(const InstructionList& other) = default;
+    InstructionList(InstructionList&& other) = default;
+    InstructionList& operator=(const InstructionList& other) = default;
+    InstructionList& operator=(InstructionList&& other) = default;
+
+    template<bool Const>
+    class Iterator {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = Instruction;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<Const, const Instruction*, Instruction*>;
+        using reference = std::conditional_t<Const, const Instruction&, Instruction&>;
+        using list_pointer = std::conditional_t<Const, const InstructionList*, InstructionList*>;
+
+        Iterator() = default;
+        Iterator(list_pointer list, const handle_t& handle) : list(list), node(handle) {}
+        operator Iterator<true>() const { return { list, node }; }
+
+        reference operator*() const { return list->nodes[node].instruction; }
+        pointer operator->() const { return &list->nodes[node].instruction; }
+        Iterator& operator++() { node = list->nodes[node].next; return *this; }
+        Iterator operator++(int) { Iterator it = *this; ++*this; return it; }
+        Iterator& operator--() { node = node == NIL ? list->tail : list->nodes[node].prev; return *this; }
+        Iterator operator--(int) { Iterator it = *this; --*this; return it; }
+        bool operator==(const Iterator& other) const { return node == other.node; }
+
+        /*
+         * @return The handle of the instruction the iterator points to.
+         */
+        handle_t handle() const { return node; }
+    private:
+        list_pointer list = nullptr;
+        handle_t node = NIL;
+    };
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    /*
+     * Inserts a new instruction before the given position.
+     *
+     * @param pos The position to insert at (end() appends the instruction).
+     * @return An iterator to the new instruction.
+     */
+    iterator insert(const_iterator pos, const Instruction& instruction);
+
+    /*
+     * Removes the instruction at the given position.
+     *
+     * @param pos The instruction's position.
+     * @return An iterator to the instruction that followed the removed one.
+     */
+    iterator erase(const_iterator pos);
+
+    /*
+     * Removes every instruction that satisfies the given predicate.
+     *
+     * @param pred The predicate.
+     * @return The amount of instructions removed.
+     */
+    template<typename Pred>
+    size_t erase_if(Pred pred) {
+        size_t removed = 0;
+        for(iterator it = begin(); it != end();) {
+            if(pred(*it)) { it = erase(it); ++removed; }
+            else ++it;
+        }
+        return removed;
+    }
+
+    void push_back(const Instruction& instruction);
+    void push_front(const Instruction& instruction);
+
+    Instruction& get(const handle_t& handle);
+    const Instruction& get(const handle_t& handle) const;
+    Instruction& front();
+    const Instruction& front() const;
+    Instruction& back();
+    const Instruction& back() const;
+    size_t size() const;
+    bool empty() const;
+
+    iterator begin() { return { this, head }; }
+    iterator end() { return { this, NIL }; }
+    const_iterator begin() const { return { this, head }; }
+    const_iterator end() const { return { this, NIL }; }
+private:
+    static constexpr handle_t NIL = -1;
+    std::pmr::vector<Node> nodes;
+    handle_t head = NIL;
+    handle_t tail = NIL;
+    handle_t free_list = NIL; // Nodes of removed instructions, linked through their next fields.
+    size_t count = 0;
+};
+
+#endif // INSTRUCTIONLIST_HPP
@@ -1,8 +1,19 @@
 #ifndef INTERMEDIATEREPRESENTATION_HPP
 #define INTERMEDIATEREPRESENTATION_HPP
 
+#include "arena.hpp"
 #include "basicblock.hpp"
+#include "cfgsnapshot.hpp"
+#include "constantpropagation.hpp"
+#include "dominatortree.hpp"
+#include "inductionvariables.hpp"
+#include "loopforest.hpp"
+#include "scalarevolution.hpp"
+#include "valuetable.hpp"
 #include <map>
+#include <memory>
+#include <memory_resource>
+#include <optional>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -59,19 +70,24 @@ struct Preference {
 class IntermediateRepresentation {
 public:
     IntermediateRepresentation();
+    // The IR is handed from stage to stage by moving it, never by copying it.
+    IntermediateRepresentation(const IntermediateRepresentation&) = delete;
+    IntermediateRepresentation(IntermediateRepresentation&&) = default;
+    IntermediateRepresentation& operator=(const IntermediateRepresentation&) = delete;
+    IntermediateRepresentation& operator=(IntermediateRepresentation&&) = default;
     void debug() const;
     bool ignore = false;
     bool while_loop = false;
     int spill_count = 0;
     /*
-     * Resets the doms vector and recomputes the dominators for every basic
-     * block in the basic_blocks vector
+     * Recomputes the dominator tree from scratch, visiting blocks in reverse postorder.
+     * New blocks are added to the tree as they're created, so this only needs to run
+     * after the CFG has been changed in some other way.
      */
     void compute_dominators();
 
     /*
-     * Utilizes the Cooper-Harvey-Kennedy algorithm to determine the closest
-     * dominator the two given basic blocks have in common. This function
+     * Determines the closest dominator the two given basic blocks have in common. This function
      * is mainly used to determine the immediate dominator of a basic block
      * given it's two parents. 
      * 
@@ -81,6 +97,13 @@ public:
      */
     bb_t intersect(bb_t b1, bb_t b2) const;
 
+    /*
+     * @param a The possible dominator's index.
+     * @param b The given block's index.
+     * @return true if block a dominates block b (a block dominates itself).
+     */
+    bool dominates(const bb_t& a, const bb_t& b) const;
+
     /*
      * Creates a new block with the given parent. The block's
      * type will be NONE. This function should only be called
@@ -253,45 +276,17 @@ public:
      */
     instruct_t prepend_instruction(const bb_t& b, Opcode op, const std::pair<instruct_t, ident_t>& larg, const std::pair<instruct_t, ident_t>& rarg);
 
-   /*
-    * Given a while loop's scope from its header block to its branch back block,
-    * this function generates phi functions based off the differences in identifier values
-    * of the loop header block and branch back block. Then, the instruction numbers of the
-    * new phi functions are propagated across the while loop's scope, replacing old identifier
-    * values with the new phi functions' instruction numbers.
-    *
-    * @param loop_header The while loop's header.
-    * @param branch_back The while loop's branch block.
-    */
-    void generate_phi(const bb_t& loop_header, const bb_t& branch_back);
-    void update_phi(const bb_t& loop_header, const bb_t& branch_back);
-
-    /*
-     * Given a vector of tuples containing information about identifiers that should be changed and what their value should be
-     * changed to, this function will update those identifiers with the given new values, starting from the given current block 
-     * and down through the control flow graph until there are no blocks to travel to.
-     * 
-     * @param curr_block The first block to be changed.
-     * @param changed_idents First argument is the index of the identifier in any basic block's identifier values vector. Second
-     * argument is the new instruction number it should be changed to. Third argument is the old instruction number that should be changed to
-     * the new instruction number.
-     */
-    void update_ident_vals_loop(const bb_t& curr_block, const std::vector<std::tuple<int, instruct_t, instruct_t>>& changed_idents);
-
-    // OUTDATED (Kept for now)
-    void update_ident_vals_until(bb_t curr_block, bb_t stop_block, const std::vector<std::tuple<int, instruct_t, instruct_t>>& changed_idents);
-
     /*
-     * Given a block and a tuple containing information about identifiers that should be changed and what their value should be changed to,
-     * this function will update those identifiers with the given new values for this block.
+     * Finishes a while loop's header once the loop's body (ending with the given branch back
+     * block) has been parsed. Phi functions that were created for identifiers read inside of the
+     * loop get their right (back edge) arguments, and phi functions are created for identifiers that
+     * were only assigned inside of the loop. Trivial phi functions are then removed, replacing their
+     * uses throughout the loop with the value that entered the loop.
      *
-     * @param b The given block.
-     * @param changed_idents First argument is the index of the identifier in any basic block's identifier values vector. Second
-     * argument is the new instruction number it should be changed to. Third argument is the old instruction number that should be changed to
-     * the new instruction number.
-     * @param skip_phi If true, phi instructions are not changed. Else, they are changed like every other instruction.
+     * @param loop_header The while loop's header.
+     * @param branch_back The while loop's branch back block, or -1 if the loop's body is never executed.
      */
-    void update_ident_vals(const bb_t& b, const std::vector<std::tuple<int, instruct_t, instruct_t>>& changed_idents, const bool& skip_phi);
+    void update_phi(const bb_t& loop_header, const bb_t& branch_back);
 
     /*
      * Returns the instruction number of the given block's first instruction.
@@ -305,8 +300,9 @@ public:
 
     /*
      * Searches for potential common subexpressions with the given opcode, left argument,
-     * and right argument. First searches through the given block, then through the given
-     * block's immediate dominator, then through that dominator's immediate dominator, etc.
+     * and right argument among the instructions of the given block and its dominators.
+     * The search is a single probe of the scoped value table once the given block's scope
+     * is open, so it doesn't depend on how many instructions the dominators hold.
      *
      * @param b The given block's index.
      * @param op The opcode being looked for. If CSEs are not possible for this opcode, this
@@ -321,6 +317,8 @@ public:
 
     /*
      * Returns the instruction number the given identifier is assigned to in the given block.
+     * If the identifier hasn't been assigned since entering a loop that's still being parsed,
+     * this creates the loop header's phi function for the identifier.
      *
      * @param b The given block's index.
      * @param ident The given identifier's index.
@@ -422,20 +420,55 @@ public:
      * @return The index of the given block's immediate dominator.
      */ 
     const bb_t& get_idom(const bb_t& b) const;
+    const DominatorTree& get_dominator_tree() const;
+
+    /*
+     * Returns the dominance frontier of the given block. The frontiers of every block are
+     * computed the first time one is asked for and kept until the CFG changes.
+     *
+     * @param b The given block's index.
+     * @return The blocks in the given block's dominance frontier.
+     */
+    const std::vector<bb_t>& get_dominance_frontier(const bb_t& b);
+
+    /*
+     * Returns the loop forest of the CFG. It's computed the first time it's asked for
+     * and kept until the CFG changes.
+     *
+     * @return The IR's loop forest.
+     */
+    const LoopForest& get_loop_forest();
+
+    /*
+     * Returns a flat snapshot of the CFG's edges along with its postorder and reverse postorder.
+     * It's taken the first time it's asked for and kept until the CFG changes, so it's meant
+     * for the stages after parsing, once the CFG is final.
+     *
+     * @return The IR's CFG snapshot.
+     */
+    const CFGSnapshot& get_cfg();
+
+    /*
+     * @param b The given block's index.
+     * @return The amount of loops the given block is in (0 if it isn't in a loop).
+     */
+    size_t get_loop_depth(const bb_t& b);
     const Blocktype& get_block_type(const bb_t& b) const;
-    const std::vector<BasicBlock>& get_basic_blocks() const;
-    std::unordered_set<instruct_t>& get_live_ins(const bb_t& b);
-    std::unordered_map<instruct_t, std::unordered_set<instruct_t>>& get_death_points();
+    const std::pmr::vector<BasicBlock>& get_basic_blocks() const;
+    std::pmr::unordered_set<instruct_t>& get_live_ins(const bb_t& b);
+    std::pmr::unordered_map<instruct_t, std::pmr::unordered_set<instruct_t>>& get_death_points();
     const Register& get_assigned_register(const instruct_t& instruct) const;
-    const std::vector<instruct_t>& get_predecessors(const bb_t& b) const;
-    const std::vector<instruct_t>& get_successors(const bb_t& b) const;
-    const std::vector<Instruction>& get_instructions(const bb_t& b) const;
-    const instruct_t& get_loop_header(const bb_t& b) const;
-    const instruct_t& get_branch_back(const bb_t& b) const;
+    const std::pmr::vector<bb_t>& get_predecessors(const bb_t& b) const;
+    const std::pmr::vector<bb_t>& get_successors(const bb_t& b) const;
+    const InstructionList& get_instructions(const bb_t& b) const;
+    const bb_t& get_loop_header(const bb_t& b) const;
+    const bb_t& get_branch_back(const bb_t& b) const;
     const Blocktype& get_type(const bb_t& b) const;
     const Instruction& get_branch_instruction(const bb_t& b) const;
     const int& get_const_value(const instruct_t& instruct) const;
     const std::vector<std::pair<Register, int>>& get_instruction_preference(const instruct_t& instruct);
+    const std::pmr::unordered_set<instruct_t>& get_memoized_functions() const;
+    const std::string& get_output(const instruct_t& instruct) const;
 
     void constrain(const instruct_t& instruct, const bb_t& b, const Register& reg, const bool& propagate);
     void dislike(const instruct_t& instruct, const bb_t& b, const Register& reg, const bool& propagate);
@@ -470,18 +503,191 @@ public:
     bool is_propagated(const bb_t& b) const;
     bool is_emitted(const bb_t& b) const;
     bool is_const_block(const bb_t& b) const;
+    bool is_memoized(const instruct_t& label) const;
+
+    /*
+     * Optimizes a while loop once its phi functions are final. Redundant instructions of the
+     * loop are replaced by a dominating instruction that computes the same value, and loop-invariant
+     * instructions are hoisted into the loop's preheader. Nested loops are done before the loops
+     * containing them, so an instruction can be hoisted out of one loop at a time.
+     *
+     * @param loop_header The while loop's header.
+     * @param branch_back The while loop's branch back block.
+     */
+    void commit_while(const bb_t& loop_header, const bb_t& branch_back);
+
+    /*
+     * Unswitches a while loop once it's committed, before its exit is created. If an if statement
+     * of the loop tests a condition that doesn't change in the loop, the test is hoisted into the
+     * preheader, which branches to one of two versions of the loop: the loop itself, which always
+     * takes the if statement's then branch, and a copy of it, which always takes the else branch.
+     * Each version is entered through a preheader of its own, so the loop's blocks move up by one.
+     * Both versions exit into a JOIN block whose phi functions merge the values the versions leave.
+     * The branches not taken are cut off, so they're removed by constant propagation. Only loops
+     * within a code size budget are unswitched.
+     *
+     * @param loop_header The while loop's header.
+     * @param branch_back The while loop's branch back block.
+     * @return The JOIN block following both versions of the loop, or -1 if the loop wasn't unswitched.
+     */
+    bb_t unswitch_loop(const bb_t& loop_header, const bb_t& branch_back);
+
+    /*
+     * Copies the given blocks (and their instructions) to the given position. Edges leaving the
+     * given blocks aren't copied. Copies made anywhere but the end of the IR overwrite the (empty)
+     * blocks there, and leave the dominator tree to be recomputed.
+     *
+     * @param first The first block to copy.
+     * @param last The last block to copy.
+     * @param entry The block the copy of the first block is entered from.
+     * @param position The index of the copy of the first block.
+     * @return Maps the copied instructions to their copies.
+     */
+    std::unordered_map<instruct_t, instruct_t> copy_blocks(const bb_t& first, const bb_t& last, const bb_t& entry, const bb_t& position);
+
+    /*
+     * Makes room for (or removes) blocks by moving every block from the given position onwards by
+     * the given amount, renumbering the CFG's references to them. New blocks are empty. The dominator
+     * tree is left to be recomputed.
+     *
+     * @param position The index of the first moved block.
+     * @param count The amount of blocks to insert (or remove, if negative).
+     */
+    void shift_blocks(const bb_t& position, const ssize_t& count);
+
+    void fix_func_call(const bb_t& b, const instruct_t& instruct, const instruct_t& larg);
+
+    /*
+     * Frees the side tables that are only needed while the IR is being constructed
+     * (loop markers and the identifiers phi functions belong to). Called once parsing is done.
+     */
+    void finish_construction();
+
+    /*
+     * Turns tail recursion into loops. When a function returns the result of a call to itself from
+     * one block, its entry block is split after its parameters, and the rest becomes a loop header
+     * with a phi function per parameter. The tail call's block then branches back to the header,
+     * passing its arguments through the phi functions instead of making the call.
+     */
+    void eliminate_tail_calls();
+
+    /*
+     * Inlines calls to small functions, functions called in loops and functions only called once.
+     * A call's block is split after the call, and a copy of the callee's blocks is put in between,
+     * with its parameters replaced by the call's arguments and its returns branching to the split
+     * off block, where a phi function merges the returned values (if there's two of them). The
+     * callee's size is weighed against a budget that grows with the loops the call is in. Recursive
+     * calls aren't inlined, and functions that are no longer called are removed.
+     */
+    void inline_calls();
 
-    void commit_while(const bb_t& curr_block, const bb_t& loop_header, const bb_t& branch_back, std::map<std::string, ident_t>& identifier_table);
-    void cse_replace(const bb_t& curr_block, const bb_t& branch_back, const instruct_t& replacer, const instruct_t& to_delete);
+    /*
+     * Sparse conditional constant propagation. Instructions that always compute the same value
+     * are replaced by a constant, conditional branches that always go the same way become jumps
+     * (or fallthroughs), and blocks that can never run are emptied and cut off from the CFG. Phi
+     * functions left with one incoming edge that can be taken are replaced by its argument.
+     */
+    void propagate_constants();
+
+    /*
+     * Interprocedural constant propagation. A parameter that's passed the same constant by every
+     * call (besides recursive calls passing it on unchanged) is replaced by that constant. Calls
+     * that pass constants the others don't get a specialized copy of their callee instead, with
+     * those parameters replaced, as long as the callee fits a budget. Constants are then propagated
+     * again so the specialized bodies are folded.
+     */
+    void specialize_functions();
+
+    /*
+     * Removes calls to pure functions (functions that, along with everything they call, do no
+     * I/O) whose results are already known. Calls whose arguments are loop-invariant are hoisted
+     * into their loop's preheader if the callee always returns, and calls with the same arguments
+     * as a call that dominates them reuse its result.
+     */
+    void eliminate_redundant_calls();
+
+    /*
+     * Induction variable strength reduction. Multiplies of a loop's basic induction variables by
+     * loop-invariant factors are replaced by phi functions of their own, which are increased by
+     * factor * step next to the basic induction variable's increment. A basic induction variable
+     * left used only by comparisons is then compared through one of its (positive constant)
+     * multiples instead, leaving it to be removed as dead code. Nested loops are done first, so
+     * multiplies they leave in their preheaders are reduced by the loops containing them.
+     */
+    void reduce_strength();
+
+    /*
+     * Unrolls loops whose body is a single block and whose trip count is a constant. Loops with
+     * few iterations are fully unrolled: every iteration is copied into the preheader, after which
+     * the loop's test fails the first time and constant propagation removes the loop. Larger loops
+     * are unrolled by a factor that keeps the body within a budget, with the remaining iterations
+     * copied into the preheader. Copies are folded and deduplicated as they're made, and constant
+     * propagation is run again once any loop is unrolled.
+     */
+    void unroll_loops();
 
-    void fix_func_call(const bb_t& b, const int& index, const instruct_t& larg);
+    /*
+     * Evaluates loops that only compute values (counting and summing loops) in constant time.
+     * When the scalar evolution of a loop is computable, its branch back block computes the values
+     * its phi functions have once the loop is done, from the amount of iterations left, and sends
+     * them around the back edge instead. The loop's test then fails the next time it's run, and
+     * the loop's body is left to be removed as dead code.
+     */
+    void evaluate_closed_forms();
+
+    /*
+     * Partial evaluation. The main function is run at compile time until it reads input (or
+     * can't be run any further), and what it wrote up to the last block it got to that runs
+     * exactly once is written at once by its entry block, which then resumes at that block with
+     * the values computed so far as constants. If the main function runs to its end, all that's left
+     * is the write. Calls to pure functions with constant arguments are then replaced by their
+     * results. Running is limited by fuel, the amount of instructions that may be run.
+     */
+    void evaluate_partially();
+
+    /*
+     * Removes every instruction whose value can't affect the program's output. Instructions with
+     * side effects (and the branches ending each block) are live, as is everything they use,
+     * directly or through other live instructions. Whatever isn't reached from them is removed.
+     */
+    void eliminate_dead_code();
+
+    /*
+     * Picks the functions whose results are cached in a memo table when they're emitted: pure
+     * functions that call themselves, take one or two parameters (which make up the table's key)
+     * and return a value from every return. Exponential recursion then only computes each result
+     * once, as long as the arguments fit in the table.
+     */
+    void memoize_functions();
+
+    /*
+     * Frees the live-ins and register preferences once registers are allocated. Nothing that
+     * reads them (besides debug printing) may be called afterwards.
+     */
+    void release_allocation_analyses();
 private:
+    static constexpr size_t UNROLL_BUDGET = 64;    // The most instructions an unrolled loop body may have.
+    static constexpr size_t FULL_UNROLL_TRIPS = 8; // The most iterations a loop may have to be fully unrolled.
+    static constexpr ssize_t MAX_TRIP_COUNT = 1 << 16;
+    static constexpr size_t UNSWITCH_BUDGET = 64;  // The most instructions a loop may have to be unswitched.
+    static constexpr size_t INLINE_BUDGET = 16;          // The most instructions a callee may have to be inlined (per enclosing loop, plus one).
+    static constexpr size_t SINGLE_CALL_BUDGET = 64;     // The most instructions a callee that's only called once may have to be inlined.
+    static constexpr size_t SPECIALIZE_BUDGET = 32; // The most instructions a function may have to be specialized.
+    static constexpr size_t SPECIALIZATIONS = 4;    // The most specialized copies a function may get.
+    static constexpr size_t EVALUATION_FUEL = 1 << 20; // The most instructions partial evaluation may run (per evaluation).
+    static constexpr size_t EVALUATION_OUTPUT = 1 << 12; // The most bytes of output evaluating the main function may write.
 // Should be private:
+    /*
+     * The memory the IR's containers allocate from. It's declared first so that it outlives them,
+     * and kept behind a pointer so that moving the IR doesn't move it out from under them.
+     */
+    std::unique_ptr<Arena> arena;
+
     /*
      * This vector contains the basic blocks of the IR.
      * The bb_t type refers to the indices of this vector.
      */
-    std::vector<BasicBlock> basic_blocks;
+    std::pmr::vector<BasicBlock> basic_blocks;
 
     /*
      * This records the amount of instructions that have been added to the
@@ -491,21 +697,311 @@ private:
     int instruction_count = 0;
 
     /*
-     * This vector contains the immediate dominators of every basic block
-     * in the basic_blocks vector. For example, the nth basic block's
-     * immediate dominator would be doms[n].
+     * The dominator tree of the basic blocks. For example, the nth basic block's
+     * immediate dominator would be dom_tree.get_idom(n).
+     */
+    DominatorTree dom_tree;
+
+    /*
+     * Data that's only needed to allocate registers. It has its own arena so that all of
+     * it can be freed at once when the register allocator is done with it.
+     */
+    struct AllocationAnalyses {
+        Arena arena;
+        std::pmr::vector<std::pmr::unordered_set<instruct_t>> live_ins{ arena.resource() };
+        std::pmr::unordered_map<instruct_t, Preference> preference_list{ arena.resource() };
+    };
+    std::unique_ptr<AllocationAnalyses> allocation_analyses;
+
+    std::pmr::unordered_map<instruct_t, int> const_instructions;
+    std::pmr::unordered_map<instruct_t, Register> assigned_registers;
+    std::pmr::unordered_map<instruct_t, std::pmr::unordered_set<instruct_t>> death_points;
+
+    /*
+     * The available expressions of the block whose scope is innermost and of its dominators.
+     * Used to look up common subexpressions.
+     */
+    ValueTable value_table;
+
+    /*
+     * Markers stand in for the values identifiers have in a loop header before the loop is finished.
+     * The marker of identifier i in a loop header is -2 - (base + i), where base is the loop header's
+     * entry in loop_marker_bases. Once a marker's phi function is created, it's recorded in loop_phis.
+     */
+    std::vector<std::pair<bb_t, instruct_t>> loop_marker_bases;
+    instruct_t marker_count = 0;
+    std::pmr::unordered_map<instruct_t, instruct_t> loop_phis;
+
+    /*
+     * The labels of the functions whose results are cached in a memo table (see memoize_functions).
+     */
+    std::pmr::unordered_set<instruct_t> memoized_functions;
+
+    /*
+     * The output each WRITESTR instruction writes, computed by partial evaluation.
+     */
+    std::pmr::unordered_map<instruct_t, std::string> outputs;
+
+    /*
+     * The identifier each phi function was created for.
+     */
+    std::pmr::unordered_map<instruct_t, ident_t> phi_owners;
+
+    /*
+     * The cached loop forest of the CFG. Reset whenever blocks or loops are added.
+     */
+    std::optional<LoopForest> loop_forest;
+
+    /*
+     * The cached CFG snapshot. Reset whenever blocks or loops are added.
      */
-    std::vector<bb_t> doms;
-    std::vector<std::unordered_set<instruct_t>> live_ins;
-    std::unordered_map<instruct_t, Preference> preference_list{};
-    std::unordered_map<instruct_t, int> const_instructions {{0, 0}};
-    std::unordered_map<instruct_t, Register> assigned_registers;
-    std::unordered_map<instruct_t, std::unordered_set<instruct_t>> death_points;
+    std::optional<CFGSnapshot> cfg_snapshot;
+
+    /*
+     * The cached dominance frontiers of the basic blocks. Reset whenever blocks or loops are added.
+     */
+    std::optional<std::vector<std::vector<bb_t>>> dominance_frontiers;
+
     /* Helpers */
     bb_t new_block_helper(const bb_t& p1, const bb_t& p2, const bb_t& idom, Blocktype t);
     instruct_t add_instruction_helper(const bb_t& b, Opcode op, const std::pair<instruct_t, ident_t>& larg, const std::pair<instruct_t, ident_t>& rarg, const bool& prepend);
     Preference& get_preference(const instruct_t& instruct);
     void establish_affinity_group(const instruct_t& i1, const instruct_t& i2, const instruct_t& i3);
+    void reset_cfg_analyses();
+
+    /*
+     * Removes an instruction from the given block. The block's first instruction is turned into
+     * an EMPTY instruction instead, since its number is the label branches to the block use.
+     *
+     * @param b The given block's index.
+     * @param it The instruction's position in the block.
+     * @return The position of the instruction following the removed one.
+     */
+    InstructionList::iterator remove_instruction(const bb_t& b, InstructionList::iterator it);
+
+    /*
+     * Removes the given instructions from every block but the const block, along with their phi
+     * affinities. When a block's first instruction is removed and another one follows it, branches
+     * and calls to the block are relabeled to the following instruction.
+     *
+     * @param removed Whether each instruction (indexed by its number) should be removed.
+     */
+    void remove_instructions(const std::vector<bool>& removed);
+
+    /*
+     * Inlines the given call if its callee fits in the given budget.
+     *
+     * @param b The call's block.
+     * @param call The call (JSR) instruction.
+     * @param budget The most instructions the callee may have.
+     * @return true if the call was inlined.
+     */
+    bool inline_call(const bb_t& b, const instruct_t& call, const size_t& budget);
+
+    /*
+     * Turns the given function's tail recursion into a loop, if it has a single tail call to itself.
+     *
+     * @param function The index of the function's entry in the const block's successors.
+     * @return true if the tail call was eliminated.
+     */
+    bool eliminate_tail_call(const size_t& function);
+
+    /*
+     * Runs the main function at compile time, replacing what it got through with its output.
+     *
+     * @return true if any of the main function was evaluated.
+     */
+    bool evaluate_main();
+
+    /*
+     * Replaces calls to pure functions with constant arguments by their results.
+     *
+     * @return true if any call was replaced.
+     */
+    bool evaluate_calls();
+
+    /*
+     * Propagates constant arguments into the given function, and specializes it for the calls
+     * whose constant arguments differ from the others.
+     *
+     * @param function The index of the function's entry in the const block's successors.
+     * @return true if the function or its calls were changed.
+     */
+    bool specialize_function(const size_t& function);
+
+    /*
+     * Hoists the calls to the given functions whose arguments are loop-invariant into their loop's preheader.
+     *
+     * @param speculatable The labels of the functions that can be called even when their calls wouldn't run.
+     */
+    void hoist_calls(const std::unordered_set<instruct_t>& speculatable);
+
+    /*
+     * @return The labels of the functions that don't do I/O, directly or through the functions they call.
+     */
+    std::unordered_set<instruct_t> find_pure_functions() const;
+
+    /*
+     * @param pure The labels of the pure functions.
+     * @return The labels of the pure functions that always return (they have no loops, recursion or
+     * divisions that could trap).
+     */
+    std::unordered_set<instruct_t> find_speculatable_functions(const std::unordered_set<instruct_t>& pure) const;
+
+    /*
+     * @param b The call's block.
+     * @param call The call (JSR) instruction.
+     * @return The call's arguments (its SETPARs) in order, or nothing if they can't be found.
+     */
+    std::optional<std::vector<instruct_t>> call_arguments(const bb_t& b, const instruct_t& call) const;
+
+    /*
+     * @param entry A function's entry block.
+     * @return The amount of parameters the function has.
+     */
+    size_t parameter_count(const bb_t& entry) const;
+
+    /*
+     * Removes the functions that are no longer called, along with their blocks.
+     */
+    void remove_uncalled_functions();
+
+    /*
+     * @param label The first instruction of a function.
+     * @return The index of the function's entry in the const block's successors, or -1 if there's none.
+     */
+    ssize_t find_function(const instruct_t& label) const;
+
+    /*
+     * Reduces the strength of the derived induction variables of the given loop.
+     *
+     * @param loop The given loop.
+     */
+    void reduce_strength(const Loop& loop);
+
+    /*
+     * Replaces the comparisons using the given basic induction variable by comparisons of its
+     * multiple, if that's all it's used for.
+     *
+     * @param loop The loop of the induction variable.
+     * @param variables The loop's induction variables.
+     * @param variable The basic induction variable.
+     * @param factor The multiple's (positive) factor.
+     * @param phi The multiple's phi function.
+     * @param next The multiple's increment.
+     * @param replacements The multiplies being replaced, whose uses don't count.
+     */
+    void replace_test(const Loop& loop, const InductionVariables& variables, const InductionVariable& variable, const int& factor,
+                      const instruct_t& phi, const instruct_t& next, const std::unordered_map<instruct_t, instruct_t>& replacements);
+
+    /*
+     * Sends the closed forms of the given loop's phi functions around its back edge.
+     *
+     * @param loop The given loop.
+     * @param evolution The loop's (computable) scalar evolution.
+     */
+    void evaluate_closed_forms(const Loop& loop, const ScalarEvolution& evolution);
+
+    /*
+     * @param loop The given loop.
+     * @param variables The loop's induction variables.
+     * @return The amount of times the given loop's body runs, or -1 if it isn't a (small) constant.
+     */
+    ssize_t constant_trip_count(const Loop& loop, const InductionVariables& variables) const;
+
+    /*
+     * Appends copies of the iterations of a loop whose body is a single block to the given block.
+     * Copies of instructions with constant arguments are folded, and copies of CSE-able instructions
+     * the block already computes are replaced by them.
+     *
+     * @param b The given block.
+     * @param loop The given loop.
+     * @param values Maps the loop header's phi functions to their values at the first copied iteration.
+     * @param count The amount of iterations to copy.
+     * @return The phi functions' values after the copied iterations.
+     */
+    std::unordered_map<instruct_t, instruct_t> copy_iterations(const bb_t& b, const Loop& loop, std::unordered_map<instruct_t, instruct_t> values, const size_t& count);
+
+    /*
+     * Multiplies two values, folding them if they're both constants.
+     *
+     * @param b The block to add the multiply to, or -1 if none can be added.
+     * @param larg The left value.
+     * @param rarg The right value.
+     * @return The product, or -1 if it can't be computed at the end of the given block.
+     */
+    instruct_t multiply(const bb_t& b, const instruct_t& larg, const instruct_t& rarg);
+
+    /*
+     * @param instruction The given CSE-able instruction.
+     * @return true if executing the instruction can't trap, even when its block wouldn't have run.
+     */
+    bool is_safe_to_hoist(const Instruction& instruction) const;
+
+    /*
+     * Replaces the arguments of the instructions (and returns) of every block created since the given
+     * block according to the given map. Called on a loop header before the loop's exit is created,
+     * these are the blocks of the loop's body. Calls keep their callee's label.
+     *
+     * @param first_block The index of the first block whose instructions are changed.
+     * @param replacements Maps instruction numbers to the instruction numbers replacing them.
+     */
+    void replace_uses(const bb_t& first_block, const std::unordered_map<instruct_t, instruct_t>& replacements);
+
+    /* Loop Markers */
+    instruct_t loop_marker(const bb_t& loop_header, const ident_t& ident) const;
+    bool is_loop_marker(const instruct_t& instruct) const;
+
+    /*
+     * @param value An identifier's value.
+     * @return The phi function the given marker stands in for if it has been created, otherwise the given value.
+     */
+    instruct_t peek_value(const instruct_t& value) const;
+
+    /*
+     * Turns an identifier's value into an instruction number. A marker is resolved to the phi function it stands
+     * in for, which is created in the marker's loop header if it doesn't exist yet.
+     *
+     * @param value An identifier's value.
+     * @return The instruction number of the value.
+     */
+    instruct_t resolve_value(const instruct_t& value);
+
+    /* Value Table */
+    /*
+     * Makes the given block's scope the innermost scope of the value table. Scopes of blocks
+     * that don't dominate the given block are left, and the scopes of the given block's
+     * dominators that aren't open yet are entered by recording their CSE-able instructions.
+     *
+     * @param b The given block's index.
+     */
+    void enter_value_scope(const bb_t& b);
+
+    /*
+     * Records the given instruction of the given block in the value table if it's CSE-able.
+     *
+     * @param b The index of the block the instruction belongs to.
+     * @param instruction The given instruction.
+     */
+    void record_value(const bb_t& b, const Instruction& instruction);
+
+    /*
+     * Removes the given instruction from the value table if it's recorded there.
+     *
+     * @param instruction The given instruction.
+     */
+    void forget_value(const Instruction& instruction);
+
+    /*
+     * Changes the arguments of the given instruction of the given block, keeping the value
+     * table up to date with the instruction's new expression.
+     *
+     * @param b The index of the block the instruction belongs to.
+     * @param instruction The given instruction.
+     * @param larg The instruction's new left argument.
+     * @param rarg The instruction's new right argument.
+     */
+    void set_arguments(const bb_t& b, Instruction& instruction, const instruct_t& larg, const instruct_t& rarg);
 
     /* Debug */
     void print_const_instructions() const;
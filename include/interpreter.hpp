@@ -0,0 +1,105 @@
+#ifndef INTERPRETER_HPP
+#define INTERPRETER_HPP
+
+#include "basicblock.hpp"
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * A point the main function's evaluation got past: the block it was about to run (with the
+ * block's phi functions already evaluated), the output written before it, and the value of
+ * every instruction run so far.
+ */
+struct Checkpoint {
+    bb_t block = -1;
+    size_t output_size = 0;
+    std::unordered_map<instruct_t, long long> values;
+};
+
+/*
+ * Runs the IR at compile time. Values are computed in 64 bits like the emitted code does, and
+ * running stops (unsuccessfully) at anything only the running program can do: reading input,
+ * trapping on a division, recursing too deeply, using up its fuel (the amount of instructions
+ * it may run), or writing more output than the emitted program should hold.
+ */
+class Interpreter {
+public:
+    /*
+     * @param basic_blocks The IR's basic blocks.
+     * @param const_instructions The values of the const block's instructions.
+     * @param instruction_count The highest instruction number in use.
+     * @param fuel The most instructions that may be run.
+     */
+    Interpreter(const std::pmr::vector<BasicBlock>& basic_blocks, const std::pmr::unordered_map<instruct_t, int>& const_instructions, const instruct_t& instruction_count, const size_t& fuel);
+
+    /*
+     * Calls a function that does no I/O.
+     *
+     * @param label The function's label.
+     * @param arguments The call's arguments in order.
+     * @return The value the function returns, or nothing if it couldn't be run to completion.
+     */
+    std::optional<long long> call(const instruct_t& label, const std::vector<long long>& arguments);
+
+    /*
+     * Runs the main function, recording what it writes and a checkpoint at every given block it enters.
+     *
+     * @param entry The main function's entry block.
+     * @param checkpoints The blocks to record checkpoints at (blocks that can only run once).
+     * @param output_budget The most bytes of output that may be written.
+     * @return true if the main function was run to completion.
+     */
+    bool run(const bb_t& entry, const std::vector<bool>& checkpoints, const size_t& output_budget);
+
+    /*
+     * @return The output written by the main function.
+     */
+    const std::string& get_output() const;
+
+    /*
+     * @return The last checkpoint recorded, if any.
+     */
+    const std::optional<Checkpoint>& get_checkpoint() const;
+private:
+    static constexpr size_t MAX_DEPTH = 1024; // The most calls that may be running at once.
+
+    const std::pmr::vector<BasicBlock>& basic_blocks;
+    const std::pmr::unordered_map<instruct_t, int>& const_instructions;
+    std::vector<const Instruction*> definitions;
+    std::unordered_map<instruct_t, bb_t> labels; // Maps a block's first instruction to the block.
+    size_t fuel;
+    size_t depth = 0;
+    bool writes = false; // Output may be written.
+    size_t output_budget = 0;
+    std::vector<long long> parameters;
+    std::string output;
+    const std::vector<bool>* checkpoints = nullptr;
+    std::optional<Checkpoint> checkpoint;
+
+    /*
+     * Runs a function from the given block until it returns.
+     *
+     * @param entry The function's entry block.
+     * @return The value it returns (0 for none, or if the main function ends), or nothing if it couldn't be run.
+     */
+    std::optional<long long> execute(const bb_t& entry);
+
+    /*
+     * @param values The values of the running function's instructions.
+     * @param instruct The given instruction (or constant).
+     * @return The instruction's value, or nothing if it hasn't been run.
+     */
+    std::optional<long long> value(const std::unordered_map<instruct_t, long long>& values, const instruct_t& instruct) const;
+
+    /*
+     * @param b The block whose branch instruction is run.
+     * @param values The values of the running function's instructions.
+     * @return The block control flows to, or -1 if it can't be known.
+     */
+    bb_t next_block(const bb_t& b, const std::unordered_map<instruct_t, long long>& values) const;
+};
+
+#endif // INTERPRETER_HPP
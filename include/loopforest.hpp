@@ -0,0 +1,76 @@
+#ifndef LOOPFOREST_HPP
+#define LOOPFOREST_HPP
+
+#include "basicblock.hpp"
+#include <vector>
+
+using loop_t = ssize_t;
+
+/*
+ * A natural loop of the CFG. The loop's back edge is the (implicit) edge from its
+ * branch back block to its header.
+ */
+struct Loop {
+    bb_t header;
+    bb_t branch_back;
+    bb_t preheader; // The block falling through to the header, or -1 if it also branches elsewhere.
+    loop_t parent = -1; // The innermost loop containing this one, or -1 if this loop is outermost.
+    std::vector<loop_t> children;
+    size_t depth = 1; // 1 for outermost loops.
+    std::vector<bb_t> blocks; // Sorted, including the blocks of nested loops.
+    std::vector<bb_t> exits; // Blocks outside of the loop with a predecessor inside of it.
+};
+
+/*
+ * The nesting forest of the natural loops in the CFG. Loops are indexed by loop_t,
+ * parents always coming before their children.
+ */
+class LoopForest {
+public:
+    /*
+     * Computes the loop forest of the given basic blocks. Loop headers and branch back
+     * blocks are identified by their branch_block and loop_header fields.
+     *
+     * @param basic_blocks The IR's basic blocks.
+     */
+    LoopForest(const std::pmr::vector<BasicBlock>& basic_blocks);
+
+    /*
+     * Finds the blocks of the natural loop of the given loop header: the header and every
+     * block that can reach its branch back block without passing through the header.
+     *
+     * @param basic_blocks The IR's basic blocks.
+     * @param loop_header The loop's header.
+     * @return The loop's blocks, sorted by index (which is a preorder of the dominator tree).
+     */
+    static std::vector<bb_t> natural_loop(const std::pmr::vector<BasicBlock>& basic_blocks, const bb_t& loop_header);
+
+    /*
+     * @param b The given block's index.
+     * @return The innermost loop containing the given block, or -1 if it isn't in a loop.
+     */
+    loop_t get_loop(const bb_t& b) const;
+
+    /*
+     * @param b The given block's index.
+     * @return The amount of loops containing the given block (0 if it isn't in a loop).
+     */
+    size_t get_loop_depth(const bb_t& b) const;
+
+    /*
+     * @param loop The given loop.
+     * @param b The given block's index.
+     * @return true if the given block is in the given loop or in one of its nested loops.
+     */
+    bool contains(const loop_t& loop, const bb_t& b) const;
+
+    const Loop& get(const loop_t& loop) const;
+    const std::vector<Loop>& get_loops() const;
+    const std::vector<loop_t>& get_top_level_loops() const;
+private:
+    std::vector<Loop> loops;
+    std::vector<loop_t> block_loops;
+    std::vector<loop_t> top_level_loops;
+};
+
+#endif // LOOPFOREST_HPP
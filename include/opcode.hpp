@@ -1,56 +1,85 @@
 #ifndef OPCODE_HPP
 #define OPCODE_HPP
 
+#include <array>
+#include <cstdint>
 #include <vector>
 #include <string>
 
-// CSE_COUNT is the size of the 2D vector in BasicBlock for storing CSE 
-// instructions (and storing non-CSE opcodes in the OTHER index)
+/*
+ * Properties of an opcode, stored as bit flags in opcode_traits so that
+ * classifying an instruction is a single table lookup.
+ */
+enum OpcodeTrait : std::uint8_t {
+    HAS_RESULT = 1 << 0,       // Defines a value that needs a register.
+    IS_BRANCH = 1 << 1,        // Ends its block by transferring control.
+    IS_CSE = 1 << 2,           // Can be a common subexpression (recorded in the value table).
+    IS_COMMUTATIVE = 1 << 3,   // Its arguments can be swapped.
+    CLOBBERS_FLAGS = 1 << 4,   // Its emitted code changes the flags register.
+    HAS_SIDE_EFFECTS = 1 << 5, // Can't be removed, even if its value is never used.
+    FIXED_REGISTER = 1 << 6,   // Its value or argument must be in a specific register.
+    VALUE_OPERANDS = 1 << 7,   // Its arguments are values the register allocator keeps alive.
+};
+
 #define OPCODE_LIST \
-    OPCODE(ADD, add) \
-    OPCODE(SUB, sub) \
-    OPCODE(MUL, mul) \
-    OPCODE(DIV, div) \
-    OPCODE(CONST, const) \
-    OPCODE(CSE_COUNT, ) \
-    OPCODE(CMP, cmp) \
-    OPCODE(PHI, phi) \
-    OPCODE(END, end) \
-    OPCODE(BRA, bra) \
-    OPCODE(BNE, bne) \
-    OPCODE(BEQ, beq) \
-    OPCODE(BLE, ble) \
-    OPCODE(BLT, blt) \
-    OPCODE(BGE, bge) \
-    OPCODE(BGT, bgt) \
-    OPCODE(JSR, jsr) \
-    OPCODE(RET, ret) \
-    OPCODE(GETPAR, getpar) \
-    OPCODE(GETPAR1, getpar1) \
-    OPCODE(GETPAR2, getpar2) \
-    OPCODE(GETPAR3, getpar3) \
-    OPCODE(SETPAR, setpar) \
-    OPCODE(SETPAR1, setpar1) \
-    OPCODE(SETPAR2, setpar2) \
-    OPCODE(SETPAR3, setpar3) \
-    OPCODE(MOV, mov) \
-    OPCODE(SWAP, swap) \
-    OPCODE(READ, read) \
-    OPCODE(WRITE, write) \
-    OPCODE(WRITENL, writenl) \
-    OPCODE(EMPTY, \\<empty\\>) \
-    OPCODE(DELETED, \\<deleted\\>) \
-
-enum Opcode {
-#define OPCODE(name, str) name,
+    OPCODE(ADD, add, HAS_RESULT | IS_CSE | IS_COMMUTATIVE | CLOBBERS_FLAGS | VALUE_OPERANDS) \
+    OPCODE(SUB, sub, HAS_RESULT | IS_CSE | CLOBBERS_FLAGS | VALUE_OPERANDS) \
+    OPCODE(MUL, mul, HAS_RESULT | IS_CSE | IS_COMMUTATIVE | CLOBBERS_FLAGS | VALUE_OPERANDS) \
+    OPCODE(DIV, div, HAS_RESULT | IS_CSE | CLOBBERS_FLAGS | VALUE_OPERANDS) \
+    OPCODE(CONST, const, HAS_RESULT | IS_CSE) \
+    OPCODE(CMP, cmp, CLOBBERS_FLAGS | VALUE_OPERANDS) \
+    OPCODE(PHI, phi, HAS_RESULT) \
+    OPCODE(END, end, IS_BRANCH | HAS_SIDE_EFFECTS) \
+    OPCODE(BRA, bra, IS_BRANCH | HAS_SIDE_EFFECTS) \
+    OPCODE(BNE, bne, IS_BRANCH | HAS_SIDE_EFFECTS) \
+    OPCODE(BEQ, beq, IS_BRANCH | HAS_SIDE_EFFECTS) \
+    OPCODE(BLE, ble, IS_BRANCH | HAS_SIDE_EFFECTS) \
+    OPCODE(BLT, blt, IS_BRANCH | HAS_SIDE_EFFECTS) \
+    OPCODE(BGE, bge, IS_BRANCH | HAS_SIDE_EFFECTS) \
+    OPCODE(BGT, bgt, IS_BRANCH | HAS_SIDE_EFFECTS) \
+    OPCODE(JSR, jsr, HAS_RESULT | CLOBBERS_FLAGS | HAS_SIDE_EFFECTS) \
+    OPCODE(RET, ret, HAS_RESULT | IS_BRANCH | HAS_SIDE_EFFECTS | FIXED_REGISTER | VALUE_OPERANDS) \
+    OPCODE(GETPAR, getpar, HAS_RESULT | HAS_SIDE_EFFECTS) \
+    OPCODE(GETPAR1, getpar1, HAS_RESULT | HAS_SIDE_EFFECTS) \
+    OPCODE(GETPAR2, getpar2, HAS_RESULT | HAS_SIDE_EFFECTS) \
+    OPCODE(GETPAR3, getpar3, HAS_RESULT | HAS_SIDE_EFFECTS) \
+    OPCODE(SETPAR, setpar, HAS_SIDE_EFFECTS | VALUE_OPERANDS) \
+    OPCODE(SETPAR1, setpar1, HAS_SIDE_EFFECTS | VALUE_OPERANDS) \
+    OPCODE(SETPAR2, setpar2, HAS_SIDE_EFFECTS | VALUE_OPERANDS) \
+    OPCODE(SETPAR3, setpar3, HAS_SIDE_EFFECTS | VALUE_OPERANDS) \
+    OPCODE(MOV, mov, VALUE_OPERANDS) \
+    OPCODE(SWAP, swap, VALUE_OPERANDS) \
+    OPCODE(READ, read, HAS_RESULT | HAS_SIDE_EFFECTS | FIXED_REGISTER) \
+    OPCODE(WRITE, write, HAS_SIDE_EFFECTS | FIXED_REGISTER | VALUE_OPERANDS) \
+    OPCODE(WRITENL, writenl, HAS_SIDE_EFFECTS) \
+    OPCODE(WRITESTR, writestr, HAS_SIDE_EFFECTS) \
+    OPCODE(EMPTY, \\<empty\\>, 0) \
+
+enum Opcode : std::uint8_t {
+#define OPCODE(name, str, traits) name,
     OPCODE_LIST
 #undef OPCODE
 };
 
 static const std::vector<std::string> opcode_str_list {
-#define OPCODE(name, str) #str,
+#define OPCODE(name, str, traits) #str,
     OPCODE_LIST
 #undef OPCODE
 };
 
+inline constexpr std::array opcode_traits = std::to_array<std::uint8_t>({
+#define OPCODE(name, str, traits) traits,
+    OPCODE_LIST
+#undef OPCODE
+});
+
+/*
+ * @param op The given opcode.
+ * @param trait The given trait.
+ * @return True if the opcode has the trait, false otherwise.
+ */
+constexpr bool has_trait(Opcode op, OpcodeTrait trait) {
+    return opcode_traits[op] & trait;
+}
+
 #endif // OPCODE_HPP
@@ -32,7 +32,8 @@ private:
     Lexer lexer;
     IntermediateRepresentation ir;
     const int const_block = 0;
-    std::vector<std::tuple<bb_t, int, std::string>> incomplete_func_calls;
+    std::vector<std::tuple<bb_t, instruct_t, std::string>> incomplete_func_calls;
+    std::vector<instruct_t> function_labels; // The labels of the functions declared so far, indexed by their identifiers.
     
     // const map is used to determine the operation to perform when given a specific Terminal Symbol
     const std::unordered_map<Terminal, std::pair<Opcode, std::function<instruct_t(instruct_t, instruct_t)>>> operations_map = {
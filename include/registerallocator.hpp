@@ -7,6 +7,10 @@ class RegisterAllocator {
 public:
     RegisterAllocator(IntermediateRepresentation&& ir);
     void allocate_registers();
+
+    /*
+     * Releases the intermediate representation object via move semantics.
+     */
     IntermediateRepresentation release_ir();
     void debug() const;
 private:
@@ -15,14 +19,12 @@ private:
     /* Liveness Analysis */
     void liveness_analysis();
     void analyze_block(const bb_t& block);
-    void get_phi_liveness(const bb_t& block, const std::vector<Instruction>& instructions, const bool& left);
-    bool non_reg_instruction(const Instruction& instruction);
+    void get_phi_liveness(const bb_t& block, const InstructionList& instructions, const bool& left);
     void check_argument_deaths(const Instruction& instruction, const bb_t& block);
     void apply_constraints(const Instruction& instruction, const bb_t& block);
 
     void propagate_death_deletions(const bb_t& loop_header);
-    void delete_deaths(const bb_t& curr_block, const std::unordered_set<instruct_t>& alives);
-    void delete_deaths_loop(const bb_t& curr_block, const std::unordered_set<instruct_t>& alives);
+    void delete_deaths(const bb_t& curr_block, const std::pmr::unordered_set<instruct_t>& alives);
 
     /* Color Graph */
     void color_ir();
@@ -0,0 +1,59 @@
+#ifndef SCALAREVOLUTION_HPP
+#define SCALAREVOLUTION_HPP
+
+#include "inductionvariables.hpp"
+#include <optional>
+
+/*
+ * How a phi function of a loop's header changes every iteration: something is added to it (or
+ * subtracted from it). Added loop-invariant values make it an affine recurrence. Added basic
+ * induction variables make it a polynomial (quadratic) recurrence.
+ */
+struct Recurrence {
+    instruct_t phi;
+    instruct_t addend;     // A loop-invariant value, or a basic induction variable's phi function or increment.
+    bool negated;          // The addend is subtracted instead.
+    ssize_t variable = -1; // The basic induction variable the addend is, or -1 if it's loop-invariant.
+    bool incremented;      // The addend is the basic induction variable's increment rather than its phi function.
+};
+
+/*
+ * The amount of iterations a loop has left at the start of an iteration. The loop keeps going
+ * while a basic induction variable stays below (or above) a loop-invariant bound.
+ */
+struct TripCount {
+    size_t variable; // The basic induction variable's index.
+    instruct_t bound;
+    bool inclusive;  // The variable may reach the bound (<= or >=) rather than only approach it (< or >).
+};
+
+/*
+ * Scalar evolution of a loop without nested loops or side effects. Every phi function of its
+ * header must be a recurrence, and the loop's test (in its header) must compare a basic induction
+ * variable stepping towards a loop-invariant bound, so that the loop's trip count can be computed
+ * before it runs. The values the phi functions have once the loop is done then have closed forms.
+ */
+class ScalarEvolution {
+public:
+    /*
+     * @param basic_blocks The IR's basic blocks.
+     * @param const_instructions The values of the const block's instructions.
+     * @param loop The given loop.
+     */
+    ScalarEvolution(const std::pmr::vector<BasicBlock>& basic_blocks, const std::pmr::unordered_map<instruct_t, int>& const_instructions, const Loop& loop);
+
+    /*
+     * @return true if the loop's trip count and the closed forms of its phi functions are known.
+     */
+    bool is_computable() const;
+
+    const InductionVariables& get_induction_variables() const;
+    const std::vector<Recurrence>& get_recurrences() const;
+    const TripCount& get_trip_count() const;
+private:
+    InductionVariables variables;
+    std::vector<Recurrence> recurrences;
+    std::optional<TripCount> trip_count;
+};
+
+#endif // SCALAREVOLUTION_HPP
@@ -0,0 +1,98 @@
+#ifndef VALUETABLE_HPP
+#define VALUETABLE_HPP
+
+#include "instruction.hpp"
+#include <unordered_map>
+#include <vector>
+
+using bb_t = ssize_t;
+
+/*
+ * The key a CSE-able instruction is stored under in the ValueTable. Commutative
+ * opcodes (ADD and MUL) have their arguments normalized so that "a + b" and "b + a"
+ * produce the same key.
+ */
+struct ValueKey {
+    Opcode opcode;
+    instruct_t larg;
+    instruct_t rarg;
+    ValueKey(Opcode op, const instruct_t& x1, const instruct_t& x2);
+    bool operator==(const ValueKey& other) const = default;
+};
+
+struct ValueKeyHash {
+    size_t operator()(const ValueKey& key) const;
+};
+
+/*
+ * A scoped hash table of available expressions. The open scopes always form a path
+ * down the dominator tree (the const block being the root scope), so every definition
+ * visible from the innermost scope belongs to a dominator of it. Each key maps to a
+ * stack of definitions ordered by scope depth, which makes a lookup a single hash probe
+ * and leaving a scope a pop of the keys that scope defined.
+ */
+class ValueTable {
+public:
+    /*
+     * Opens a new innermost scope for the given block. The block should be
+     * immediately dominated by the current innermost scope's block.
+     *
+     * @param b The index of the block that is being entered.
+     */
+    void enter_scope(const bb_t& b);
+
+    /*
+     * Closes the innermost scope, removing every definition it made.
+     */
+    void leave_scope();
+
+    /*
+     * @return The block of the innermost scope.
+     */
+    bb_t current_scope() const;
+
+    /*
+     * @param b The given block's index.
+     * @return true if the given block is one of the open scopes.
+     */
+    bool in_scope(const bb_t& b) const;
+
+    /*
+     * Searches for an expression that is available in the given (open) scope.
+     *
+     * @param b The block the search is performed from. Must be in scope.
+     * @param key The expression being looked for.
+     * @return The instruction number that computes the expression, or -1 if there is none.
+     */
+    instruct_t lookup(const bb_t& b, const ValueKey& key) const;
+
+    /*
+     * Records that the given instruction computes the given expression in the given
+     * (open) scope. If that scope already has a definition for the expression, the older
+     * definition is kept.
+     *
+     * @param b The block the instruction belongs to. Must be in scope.
+     * @param key The expression the instruction computes.
+     * @param instruct The instruction number.
+     */
+    void insert(const bb_t& b, const ValueKey& key, const instruct_t& instruct);
+
+    /*
+     * Removes the given instruction's definition of the given expression, if it exists.
+     *
+     * @param key The expression the instruction computes.
+     * @param instruct The instruction number.
+     */
+    void erase(const ValueKey& key, const instruct_t& instruct);
+private:
+    struct Definition {
+        instruct_t instruct;
+        size_t depth;
+    };
+    std::unordered_map<ValueKey, std::vector<Definition>, ValueKeyHash> definitions;
+    std::unordered_map<bb_t, size_t> scope_depths;
+    std::vector<bb_t> scopes;
+    std::vector<std::vector<ValueKey>> scope_keys;
+};
+
+#endif // VALUETABLE_HPP
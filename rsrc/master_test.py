@@ -1,5 +1,72 @@
+import os
+import pty
+import stat
+import subprocess
+import sys
+import tempfile
+import termios
+
+# Every program in rsrc/tests is compiled and run. NAME.ty is run with NAME.in as its input (if it
+# exists) and must print exactly NAME.out. NAME.flags holds extra compiler flags (such as -M).
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+TESTS_DIR = os.path.join(ROOT, "rsrc", "tests")
+COMPILER = os.path.join(ROOT, "bin", "compilertest_main")
+TIMEOUT = 10
+
+def read(path, default=None):
+    if not os.path.exists(path):
+        return default
+    with open(path) as file:
+        return file.read()
+
+def run_program(binary, text):
+    # InputNum reads whatever is available, so the input comes from a terminal that hands out one line per read
+    master, slave = pty.openpty()
+    try:
+        attributes = termios.tcgetattr(slave)
+        attributes[3] &= ~termios.ECHO
+        termios.tcsetattr(slave, termios.TCSANOW, attributes)
+        # End of file (^D) is sent after the input, in case the program reads more than it was given
+        os.write(master, (text + "\x04").encode())
+        return subprocess.run([binary], stdin=slave, capture_output=True, text=True, timeout=TIMEOUT)
+    finally:
+        os.close(slave)
+        os.close(master)
+
+def run_test(name):
+    base = os.path.join(TESTS_DIR, name)
+    flags = read(base + ".flags", "").split()
+    with tempfile.TemporaryDirectory() as directory:
+        # The assembler writes the binary (my.out) to the working directory
+        compiled = subprocess.run([COMPILER, base + ".ty", *flags, "-o", os.path.join(directory, "out.s")],
+                                  cwd=directory, capture_output=True, text=True, timeout=TIMEOUT)
+        if compiled.returncode != 0:
+            return "compiler exited with " + str(compiled.returncode) + "\n" + compiled.stderr
+        binary = os.path.join(directory, "my.out")
+        os.chmod(binary, os.stat(binary).st_mode | stat.S_IXUSR)
+        ran = run_program(binary, read(base + ".in", ""))
+    if ran.returncode != 0:
+        return "program exited with " + str(ran.returncode)
+    expected = read(base + ".out")
+    if ran.stdout != expected:
+        return "expected:\n" + expected + "got:\n" + ran.stdout
+    return None
+
 def main():
-    pass
+    names = sorted(f[:-3] for f in os.listdir(TESTS_DIR) if f.endswith(".ty"))
+    failures = 0
+    for name in names:
+        try:
+            error = run_test(name)
+        except subprocess.TimeoutExpired:
+            error = "timed out"
+        if error is None:
+            print("PASS " + name)
+        else:
+            failures += 1
+            print("FAIL " + name + ": " + error)
+    print(str(len(names) - failures) + "/" + str(len(names)) + " passed")
+    sys.exit(1 if failures else 0)
 
 if __name__ == "__main__":
     main()
@@ -0,0 +1,7 @@
+#include "arena.hpp"
+
+Arena::Arena() : chunks(1 << 16), pools(&chunks) {}
+
+std::pmr::memory_resource* Arena::resource() {
+    return &pools;
+}
@@ -220,8 +220,30 @@ void Assembler::read_symbols()
 void Assembler::read_data(std::istream_iterator<std::string>& is) {
     curr_offset += (0x1000 - (curr_offset % 0x1000));
 
-    sym_table["strResult"] = curr_offset;
-    sym_table["buff"] = curr_offset+21;
+    // The data section is labels followed by zeroed space (.space SIZE, FILL or .skip SIZE) or bytes (.byte B, B, ...)
+    std::istream_iterator<std::string> end{};
+    while (is != end) {
+        std::string token{*is};
+        ++is;
+        if (token.ends_with(':')) {
+            token.pop_back();
+            sym_table[token] = curr_offset + data.size();
+        } else if ((token == ".space" || token == ".skip") && is != end) {
+            std::string size{*is};
+            ++is;
+            data.resize(data.size() + std::stoull(size), 0);
+            // Skip the fill value
+            if (size.ends_with(',') && is != end) {
+                ++is;
+            }
+        } else if (token == ".byte") {
+            for (bool more = true; more && is != end; ++is) {
+                std::string byte{*is};
+                more = byte.ends_with(',');
+                data.push_back(static_cast<uint8_t>(std::stoi(byte)));
+            }
+        }
+    }
 }
 
 
@@ -379,6 +401,10 @@ IntelInstruction Assembler::create_lea(std::istream_iterator<std::string>& is) {
         op1.pop_back();
         op2.erase(op2.begin());
 
+        if (extended_registers.contains(op2)) {
+            result.setREXR();
+        }
+
         result.modrm.mod = 0b00;
         result.modrm.reg = registers.at(op2);
         result.modrm.rm = 0b100;
@@ -670,6 +696,9 @@ IntelInstruction Assembler::create_2opinstr(std::istream_iterator<std::string>&
         op1.erase(op1.begin());
         result.immediate = std::stol(op1);
 
+        // Spilled values are 64 bits wide, so the carry (or borrow) must reach their upper half.
+        result.setREXW();
+
         if (t2 == REGADDR) {
             if (std::isalpha(op2.front())) {
                 result.displacement = (sym_table.contains(op2)) ? VADDR_START + 0x1000 + sym_table.at(op2) : 0;
@@ -1516,11 +1545,11 @@ void Assembler::create_binary(std::string outfile_name) {
     data_hdr.p_offset = text_hdr.p_offset + text_hdr.p_memsz;
     data_hdr.p_offset = data_hdr.p_offset + (0x1000 - data_hdr.p_offset % 0x1000);
     data_hdr.p_vaddr = VADDR_START + data_hdr.p_offset;
-    data_hdr.p_filesz = 42;
-    data_hdr.p_memsz = 42;
+    data_hdr.p_filesz = data.size();
+    data_hdr.p_memsz = data.size();
 
     // 0x1000
-    std::vector<uint8_t> data_padding((0x1000-(text_hdr.p_memsz % 0x1000)) + data_hdr.p_filesz, 0);
+    std::vector<uint8_t> data_padding(0x1000-(text_hdr.p_memsz % 0x1000), 0);
 
 
     std::ofstream file(outfile_name, std::ios::binary);
@@ -1541,7 +1570,7 @@ void Assembler::create_binary(std::string outfile_name) {
     file.write(reinterpret_cast<const char*>(data_padding.data()), data_padding.size());
     // Write data segment
     // file.write(reinterpret_cast<const char*>(msg), msg_len);
-    // file.write(reinterpret_cast<const char*>(data.data()), data.size());
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
 }
 
 
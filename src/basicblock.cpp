@@ -3,45 +3,28 @@
 #include <iostream>
 
 void BasicBlock::prepend_instruction(const instruct_t& num, Opcode op, const instruct_t& x1, const instruct_t& x2) {
-    instructions.emplace(instructions.begin(), num, op, x1, x2);
-    if(op == EMPTY) empty_index = instructions.size() - 1; 
-    if(op < CSE_COUNT) partitioned_instructions[op].emplace_back(instructions.size() - 1);
+    instructions.push_front(Instruction(num, op, x1, x2));
 }
 
 void BasicBlock::add_instruction(const instruct_t& num, Opcode op, const instruct_t& x1, const instruct_t& x2) {
-    instructions.emplace_back(num, op, x1, x2);
-    if(op == EMPTY) empty_index = instructions.size() - 1;
-    if(op < CSE_COUNT) partitioned_instructions[op].emplace_back(instructions.size() - 1);
-}
-
-void BasicBlock::prepend_instruction(const instruct_t& num, Opcode op, const instruct_t& x1, const instruct_t& x2, const ident_t& x1_owner, const ident_t& x2_owner) {
-    instructions.emplace(instructions.begin(), num, op, x1, x2, x1_owner, x2_owner);
-    if(op == EMPTY) empty_index = instructions.size() - 1;
-    if(op < CSE_COUNT) partitioned_instructions[op].emplace_back(instructions.size() - 1);
-}
-
-void BasicBlock::add_instruction(const instruct_t& num, Opcode op, const instruct_t& x1, const instruct_t& x2, const ident_t& x1_owner, const ident_t& x2_owner) {
-    instructions.emplace_back(num, op, x1, x2, x1_owner, x2_owner);
-    if(op == EMPTY) empty_index = instructions.size() - 1;
-    if(op < CSE_COUNT) partitioned_instructions[op].emplace_back(instructions.size() - 1);
+    instructions.push_back(Instruction(num, op, x1, x2));
 }
 
 instruct_t BasicBlock::get_ident_value(const ident_t& ident) {
-    if(ident >= static_cast<ident_t>(identifier_values.size())) return -1;
-    return identifier_values[ident];
+    return identifier_values.get(ident);
 }
 
 void BasicBlock::change_instruction(const ident_t& ident, const instruct_t& instruct) {
-    identifier_values[ident] = instruct;
+    identifier_values.set(ident, instruct);
 }
 
 std::string BasicBlock::to_dotlang() const {
     std::string msg = std::format("bb{} [shape=record, label=\"<b>", index);
     if(type == JOIN) msg += "join\\n";
     msg += std::format("BB{} | ", index) + "{";
-    for(size_t i = 0; i < instructions.size(); ++i) {
-        msg += instructions[i].to_dotlang(); 
-        if(i != instructions.size() - 1) msg += "|";
+    for(auto it = instructions.begin(); it != instructions.end(); ++it) {
+        if(it != instructions.begin()) msg += "|";
+        msg += it->to_dotlang(); 
     }
     if(branch_instruction.instruction_number != -1) {
         if(instructions.size() != 0) msg += "|";
@@ -51,19 +34,31 @@ std::string BasicBlock::to_dotlang() const {
     return msg;
 }
 
-BasicBlock::BasicBlock(const bb_t& i)                                    
-    : partitioned_instructions(CSE_COUNT, std::vector<int>{}), type(NONE), index(i) {
+BasicBlock::BasicBlock(const bb_t& i, const allocator_type& alloc)                                    
+    : instructions(alloc), type(NONE), index(i), predecessors(alloc), successors(alloc) {
         if(i == 0) add_instruction(0, Opcode::CONST, 0, -1);
 }
 
-BasicBlock::BasicBlock(const bb_t& i, const ident_t& ident_count, const bb_t& p)               
-    : partitioned_instructions(CSE_COUNT, std::vector<int>{}), type(NONE), index(i), predecessors({p}), identifier_values(ident_count) {}
+BasicBlock::BasicBlock(const bb_t& i, const ident_t& ident_count, const bb_t& p, const allocator_type& alloc)               
+    : instructions(alloc), type(NONE), index(i), predecessors({p}, alloc), successors(alloc), identifier_values(ident_count, 0, 0, alloc.resource()) {}
+
+BasicBlock::BasicBlock(const bb_t& i, const IdentifierMap& dom_ident_vals, const bb_t& p, const allocator_type& alloc)              
+    : instructions(alloc), type(NONE), index(i), predecessors({p}, alloc), successors(alloc), identifier_values(dom_ident_vals) {}
+
+BasicBlock::BasicBlock(const bb_t& i, const IdentifierMap& dom_ident_vals, const bb_t& p, Blocktype t, const allocator_type& alloc) 
+    : instructions(alloc), type(t),    index(i), predecessors({p}, alloc), successors(alloc), identifier_values(dom_ident_vals) {}
 
-BasicBlock::BasicBlock(const bb_t& i, const std::vector<instruct_t>& dom_ident_vals, const bb_t& p)              
-    : partitioned_instructions(CSE_COUNT, std::vector<int>{}), type(NONE), index(i), predecessors({p}), identifier_values(dom_ident_vals) {}
+BasicBlock::BasicBlock(const bb_t& i, const IdentifierMap& dom_ident_vals, const bb_t& p1, const bb_t& p2, Blocktype t, const allocator_type& alloc)    
+   : instructions(alloc), type(JOIN), index(i), predecessors({p1, p2}, alloc), successors(alloc), identifier_values(dom_ident_vals) {}
 
-BasicBlock::BasicBlock(const bb_t& i, const std::vector<instruct_t>& dom_ident_vals, const bb_t& p, Blocktype t) 
-    : partitioned_instructions(CSE_COUNT, std::vector<int>{}), type(t),    index(i), predecessors({p}), identifier_values(dom_ident_vals) {}
+BasicBlock::BasicBlock(const BasicBlock& other, const allocator_type& alloc)
+    : instructions(other.instructions, alloc), type(other.type), will_return(other.will_return), index(other.index),
+      predecessors(other.predecessors, alloc), successors(other.successors, alloc), identifier_values(other.identifier_values),
+      branch_instruction(other.branch_instruction), branch_block(other.branch_block), loop_header(other.loop_header),
+      colored(other.colored), analyzed(other.analyzed), propagated(other.propagated), emitted(other.emitted) {}
 
-BasicBlock::BasicBlock(const bb_t& i, const bb_t& p1, const bb_t& p2, Blocktype t)    
-   : partitioned_instructions(CSE_COUNT, std::vector<int>{}), type(JOIN), index(i), predecessors({p1, p2}) {}
+BasicBlock::BasicBlock(BasicBlock&& other, const allocator_type& alloc)
+    : instructions(std::move(other.instructions), alloc), type(other.type), will_return(other.will_return), index(other.index),
+      predecessors(std::move(other.predecessors), alloc), successors(std::move(other.successors), alloc), identifier_values(std::move(other.identifier_values)),
+      branch_instruction(other.branch_instruction), branch_block(other.branch_block), loop_header(other.loop_header),
+      colored(other.colored), analyzed(other.analyzed), propagated(other.propagated), emitted(other.emitted) {}
@@ -0,0 +1,60 @@
+#include "cfgsnapshot.hpp"
+#include <ranges>
+
+CFGSnapshot::CFGSnapshot(const std::pmr::vector<BasicBlock>& basic_blocks) {
+    const size_t block_count = basic_blocks.size();
+    predecessor_offsets.reserve(block_count + 1);
+    successor_offsets.reserve(block_count + 1);
+    predecessor_offsets.emplace_back(0);
+    successor_offsets.emplace_back(0);
+    for(const BasicBlock& block : basic_blocks) {
+        predecessor_edges.insert(predecessor_edges.end(), block.predecessors.begin(), block.predecessors.end());
+        successor_edges.insert(successor_edges.end(), block.successors.begin(), block.successors.end());
+        predecessor_offsets.emplace_back(predecessor_edges.size());
+        successor_offsets.emplace_back(successor_edges.size());
+    }
+
+    // Iterative DFS from the const block.
+    std::vector<bool> visited(block_count, false);
+    std::vector<std::pair<bb_t, size_t>> stack{ { 0, successor_offsets[0] } };
+    visited[0] = true;
+    preorder.emplace_back(0);
+    while(!stack.empty()) {
+        auto& [b, next] = stack.back();
+        if(next < successor_offsets[b + 1]) {
+            const bb_t successor = successor_edges[next++];
+            if(visited[successor]) continue;
+            visited[successor] = true;
+            preorder.emplace_back(successor);
+            stack.emplace_back(successor, successor_offsets[successor]);
+        } else {
+            postorder.emplace_back(b);
+            stack.pop_back();
+        }
+    }
+    reverse_postorder.assign(postorder.rbegin(), postorder.rend());
+}
+
+std::span<const bb_t> CFGSnapshot::get_predecessors(const bb_t& b) const {
+    return { predecessor_edges.data() + predecessor_offsets[b], predecessor_edges.data() + predecessor_offsets[b + 1] };
+}
+
+std::span<const bb_t> CFGSnapshot::get_successors(const bb_t& b) const {
+    return { successor_edges.data() + successor_offsets[b], successor_edges.data() + successor_offsets[b + 1] };
+}
+
+const std::vector<bb_t>& CFGSnapshot::get_preorder() const {
+    return preorder;
+}
+
+const std::vector<bb_t>& CFGSnapshot::get_postorder() const {
+    return postorder;
+}
+
+const std::vector<bb_t>& CFGSnapshot::get_reverse_postorder() const {
+    return reverse_postorder;
+}
+
+size_t CFGSnapshot::size() const {
+    return predecessor_offsets.size() - 1;
+}
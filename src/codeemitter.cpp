@@ -1,4 +1,5 @@
 #include "codeemitter.hpp"
+#include <algorithm>
 #include <format>
 #include <iostream>
 
@@ -132,8 +133,9 @@ syscall                 )" /* Invoke system call */ R"(
     // Emit main blocks
     main = true;
     program_string += std::format("push %rbp\nmov %rsp, %rbp\nadd ${}, %rsp\n", -8 * ir.spill_count);
+    const std::span<const bb_t> starts = ir.get_cfg().get_successors(0);
     for(const auto& b : ir.get_basic_blocks()) {
-        if(!(b.index >= ir.get_successors(0).back())) continue;
+        if(!(b.index >= starts.back())) continue;
         // program_string += std::format("\n# BB{}\n", b.index);
         program_string += block(b.index);
     }
@@ -141,8 +143,8 @@ syscall                 )" /* Invoke system call */ R"(
     program_string += exit;
     main = false;
     // Emit function blocks
-    for(size_t index = 0; index < ir.get_successors(0).size() - 1; ++index) {
-        program_string += std::format("function{}:\n", ir.get_instructions(ir.get_successors(0).at(index)).at(0).instruction_number);
+    for(size_t index = 0; index < starts.size() - 1; ++index) {
+        program_string += std::format("function{}:\n", ir.get_instructions(starts[index]).front().instruction_number);
         program_string += std::format(R"(push %rbp
 push %rax
 push %rbx
@@ -159,12 +161,31 @@ mov %rsp, %r11
 add ${}, %rsp
 )", ((REGISTER_COUNT + 1) * 8) + 8);
         getting_pars = true;
-        for(bb_t func_index = ir.get_successors(0).at(index); func_index < ir.get_successors(0).at(index+1); ++func_index) {
+        function_entry = starts[index];
+        for(bb_t func_index = starts[index]; func_index < starts[index + 1]; ++func_index) {
             // program_string += std::format("\n# BB{}\n", func_index);
             program_string += block(func_index);
         }
     }
-    ofile << default_text_section << program_string << data_section; 
+    std::string memo_tables;
+    for(const instruct_t& label : ir.get_memoized_functions()) {
+        memo_tables += std::format("    memo{}: .space {}, 0\n", label, MEMO_ENTRIES * 16);
+    }
+    // The outputs computed at compile time, as bytes so that no characters need escaping.
+    std::string outputs;
+    for(bb_t b = starts.back(); b < static_cast<bb_t>(ir.get_basic_blocks().size()); ++b) {
+        for(const auto& instruct : ir.get_instructions(b)) {
+            if(instruct.opcode != Opcode::WRITESTR) continue;
+            const std::string& output = ir.get_output(instruct.instruction_number);
+            outputs += std::format("    output{}:\n", instruct.instruction_number);
+            for(size_t line = 0; line < output.size(); line += 16) {
+                outputs += "    .byte ";
+                for(size_t c = line; c < std::min(line + 16, output.size()); ++c) outputs += std::format("{}{}", c == line ? "" : ", ", static_cast<int>(static_cast<unsigned char>(output[c])));
+                outputs += "\n";
+            }
+        }
+    }
+    ofile << default_text_section << program_string << data_section << memo_tables << outputs; 
     ofile.close();
 }
 
@@ -175,7 +196,7 @@ std::string CodeEmitter::block(const bb_t& b) {
     if(ir.is_emitted(b)) return "";
 
     // Ensure all predecessor blocks have been emitted first.
-    for(const auto& predecessor : ir.get_predecessors(b)) {
+    for(const bb_t& predecessor : ir.get_cfg().get_predecessors(b)) {
         if(predecessor == 0) continue;
         if(!ir.is_emitted(predecessor)) return "";
     }
@@ -185,8 +206,9 @@ std::string CodeEmitter::block(const bb_t& b) {
 
         // Under the following conditions, a block may need a label for other blocks to branch to it.
         const Blocktype& t = ir.get_type(b);
-        if(t == Blocktype::JOIN || t == Blocktype::IF_BRANCH || t == Blocktype::WHILE_BRANCH || ir.is_branch_back(b) || ir.is_loop_header(b)) {
-            block_string += std::format("branch{}:\n", ir.get_instructions(b).at(0).instruction_number);
+        if(t == Blocktype::JOIN || t == Blocktype::IF_BRANCH || t == Blocktype::WHILE_BRANCH || ir.is_branch_back(b) || ir.is_loop_header(b) ||
+           (t == Blocktype::WHILE_FALLTHROUGH && rotates(ir.get_cfg().get_predecessors(b).front()))) {
+            block_string += std::format("branch{}:\n", ir.get_instructions(b).front().instruction_number);
         }
 
         // Emit instructions
@@ -195,8 +217,13 @@ std::string CodeEmitter::block(const bb_t& b) {
         }
     }
 
+    // The function's frame is set up before its entry block ends, even if it only pops parameters.
+    block_string += prologue();
+
     // Emit the branch instruction of the given block.
-    if(ir.has_branch_instruction(b)) {
+    if(ir.is_branch_back(b) && rotates(ir.get_loop_header(b))) {
+        block_string += rotated_test(b);
+    } else if(ir.has_branch_instruction(b)) {
         block_string += instruction(ir.get_branch_instruction(b));
     }
 
@@ -206,6 +233,57 @@ std::string CodeEmitter::block(const bb_t& b) {
     return block_string;
 }
 
+bool CodeEmitter::rotates(const bb_t& loop_header) {
+    if(!ir.is_loop_header(loop_header)) return false;
+
+    // The loop must still be guarded by a test and branch back with an unconditional branch.
+    const Opcode& test = ir.get_branch_instruction(loop_header).opcode;
+    if(!has_trait(test, IS_BRANCH) || test == Opcode::BRA || test == Opcode::RET || test == Opcode::END) return false;
+    if(ir.get_branch_instruction(ir.get_branch_back(loop_header)).opcode != Opcode::BRA) return false;
+
+    // The body is branched back to, so it needs a label.
+    const bb_t body = loop_header + 1;
+    return ir.get_type(body) == Blocktype::WHILE_FALLTHROUGH && ir.get_instructions(body).size() != 0;
+}
+
+std::string CodeEmitter::rotated_test(const bb_t& branch_back) {
+    const bb_t& loop_header = ir.get_loop_header(branch_back);
+    const Instruction& test = ir.get_branch_instruction(loop_header);
+    std::string emit_string;
+
+    // The phi copies are already done, so the header's instructions see the next iteration's values.
+    for(const auto& instruct : ir.get_instructions(loop_header)) {
+        emit_string += instruction(instruct);
+    }
+    emit_string += branch(ir.get_instructions(loop_header + 1).front().instruction_number, inverted_jump(test.opcode));
+
+    // Leaving the loop falls through to its exit unless another block is laid out in between.
+    if(ir.get_cfg().size() <= static_cast<size_t>(branch_back + 1) || ir.get_instructions(branch_back + 1).size() == 0 ||
+       ir.get_instructions(branch_back + 1).front().instruction_number != test.rarg) {
+        emit_string += branch(test.rarg, "jmp");
+    }
+    return emit_string;
+}
+
+std::string CodeEmitter::inverted_jump(const Opcode& opcode) {
+    switch(opcode) {
+        case(Opcode::BNE):
+            return "je";
+        case(Opcode::BEQ):
+            return "jne";
+        case(Opcode::BLE):
+            return "jg";
+        case(Opcode::BLT):
+            return "jge";
+        case(Opcode::BGE):
+            return "jl";
+        case(Opcode::BGT):
+            return "jle";
+        default:
+            return "jmp";
+    }
+}
+
 std::string CodeEmitter::branch(const instruct_t& i, const std::string& opcode) {
     return std::format("{} branch{}\n", opcode, i);
 }
@@ -274,6 +352,10 @@ std::string CodeEmitter::additive(const Instruction& i, const std::string& opera
     if(reg_str(i.larg) == reg_str(i.instruction_number)) {
         return additive_instruction(i.rarg, i.instruction_number, operand);
     } else if(reg_str(i.rarg) == reg_str(i.instruction_number)){
+        // Subtraction isn't commutative, so the difference is computed in the temporary register.
+        if(!has_trait(i.opcode, IS_COMMUTATIVE)) {
+            return std::format("mov {}, %r11\nsub {}, %r11\nmov %r11, {}\n", reg_str(i.larg), reg_str(i.rarg), reg_str(i.instruction_number));
+        }
         return additive_instruction(i.larg, i.instruction_number, operand);
     }
     return mov_instruction(i.larg, i.instruction_number) +
@@ -352,11 +434,56 @@ mov %r11, {}(%rsp)
 push %rbp
 mov %rsp, %rbp
 add ${}, %rsp 
-)", (REGISTER_COUNT * 8), (REGISTER_COUNT * 8), -8 * ir.spill_count);
+)", (REGISTER_COUNT * 8), (REGISTER_COUNT * 8), -8 * ir.spill_count) + memo_probe();
     }
     return "";
 }
 
+std::string CodeEmitter::memo_probe() {
+    const instruct_t label = ir.get_instructions(function_entry).front().instruction_number;
+    if(!ir.is_memoized(label)) return "";
+    std::vector<instruct_t> params;
+    for(const auto& instruct : ir.get_instructions(function_entry)) {
+        if(instruct.opcode == Opcode::GETPAR) params.emplace_back(instruct.instruction_number);
+    }
+
+    // %r11 becomes the entry's index (and then its address), %r12 is scratch. Neither is allocated.
+    std::string probe_string = std::format("mov {}, %r11\ncmp $0, %r11\njl memo{}_miss\ncmp ${}, %r11\njge memo{}_miss\n",
+                                           reg_str(params.front()), label, params.size() == 1 ? MEMO_ENTRIES : MEMO_ENTRIES / MEMO_COLUMNS, label);
+    if(params.size() == 2) {
+        for(int columns = 1; columns < MEMO_COLUMNS; columns *= 2) probe_string += "add %r11, %r11\n";
+        probe_string += std::format("mov {}, %r12\ncmp $0, %r12\njl memo{}_miss\ncmp ${}, %r12\njge memo{}_miss\nadd %r12, %r11\n",
+                                    reg_str(params.back()), label, MEMO_COLUMNS, label);
+    }
+    for(int size = 1; size < 16; size *= 2) probe_string += "add %r11, %r11\n";
+    return probe_string + std::format(R"(lea memo{}, %r12
+add %r12, %r11
+cmp $0, 0(%r11)
+je memo{}_probed
+add ${}, %rsp
+pop %rbp
+add ${}, %rsp
+mov 8(%r11), %rax
+ret
+memo{}_miss:
+xor %r11, %r11
+memo{}_probed:
+push %r11
+)", label, label, 8 * ir.spill_count, (REGISTER_COUNT * 8) + 8, label, label);
+}
+
+std::string CodeEmitter::memo_store(const Instruction& ret) {
+    if(main || !ir.is_memoized(ir.get_instructions(function_entry).front().instruction_number)) return "";
+    return std::format(R"(pop %r11
+cmp $0, %r11
+je memo{}_skip
+mov {}, %r12
+mov %r12, 8(%r11)
+mov $1, 0(%r11)
+memo{}_skip:
+)", ret.instruction_number, reg_str(ret.larg), ret.instruction_number);
+}
+
 std::string CodeEmitter::instruction(const Instruction& i) {
     switch(i.opcode) {
         case(Opcode::ADD):
@@ -403,7 +530,7 @@ mov %r11, %rsp
 )", i.larg, ((REGISTER_COUNT + 1) * 8 + 8), reg_str(i.instruction_number), ir.get_assigned_register(i.instruction_number) == Register::RAX ? "add $8, %rsp" : "pop %rax");
         case(Opcode::RET):
             if(!main) {
-                return prologue() + std::format(R"(add ${}, %rsp
+                return prologue() + memo_store(i) + std::format(R"(add ${}, %rsp
 pop %rbp
 add ${}, %rsp
 {}
@@ -429,6 +556,23 @@ syscall                 )" /* Invoke system call */ R"(
             return prologue() + read(i);
         case(Opcode::WRITE):
             return prologue() + write(i);
+        case(Opcode::WRITESTR):
+            return prologue() + std::format(R"(push %rax
+push %rdi
+push %rsi
+push %rdx
+push %rcx
+lea output{}, %rsi
+mov $1, %rax
+mov ${}, %rdx
+mov $1, %rdi
+syscall
+pop %rcx
+pop %rdx
+pop %rsi
+pop %rdi
+pop %rax
+)", i.instruction_number, ir.get_output(i.instruction_number).size());
         case(Opcode::WRITENL):
             return prologue() + 
 R"(push %rax
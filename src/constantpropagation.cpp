@@ -0,0 +1,219 @@
+#include "constantpropagation.hpp"
+#include <climits>
+
+ConstantPropagation::ConstantPropagation(const std::pmr::vector<BasicBlock>& basic_blocks, const std::pmr::unordered_map<instruct_t, int>& const_instructions, const instruct_t& instruction_count)
+    : basic_blocks(basic_blocks), values(instruction_count + 1), definitions(instruction_count + 1, nullptr),
+      definition_blocks(instruction_count + 1, -1), uses(instruction_count + 1), executable_blocks(basic_blocks.size(), false) {
+    // Where every instruction is defined and which instructions use it.
+    auto use = [&](const instruct_t& instruct, const instruct_t& user) {
+        if(instruct >= 0 && instruct <= instruction_count) uses[instruct].emplace_back(user);
+    };
+    auto define = [&](const Instruction& instruction, const bb_t& b) {
+        definitions[instruction.instruction_number] = &instruction;
+        definition_blocks[instruction.instruction_number] = b;
+        if(has_trait(instruction.opcode, VALUE_OPERANDS) || instruction.opcode == Opcode::PHI) {
+            use(instruction.larg, instruction.instruction_number);
+            use(instruction.rarg, instruction.instruction_number);
+        } else if(has_trait(instruction.opcode, IS_BRANCH) && instruction.opcode != Opcode::BRA) {
+            // Conditional branches use the comparison in their left argument.
+            use(instruction.larg, instruction.instruction_number);
+        }
+    };
+    for(const BasicBlock& block : basic_blocks) {
+        if(!block.instructions.empty()) labels[block.instructions.front().instruction_number] = block.index;
+        for(const Instruction& instruction : block.instructions) define(instruction, block.index);
+        if(block.branch_instruction.opcode != Opcode::EMPTY) define(block.branch_instruction, block.index);
+    }
+
+    // The const block always runs, as does every function it falls through to.
+    executable_blocks[0] = true;
+    for(const Instruction& instruction : basic_blocks[0].instructions) {
+        lower(instruction.instruction_number, { LatticeValue::CONSTANT, const_instructions.at(instruction.instruction_number) });
+    }
+    visit_branch(basic_blocks[0].branch_instruction, 0);
+
+    while(!flow_worklist.empty() || !ssa_worklist.empty()) {
+        while(!flow_worklist.empty()) {
+            const bb_t b = flow_worklist.back().second;
+            flow_worklist.pop_back();
+            visit_block(b);
+        }
+        while(!ssa_worklist.empty()) {
+            const instruct_t instruct = ssa_worklist.back();
+            ssa_worklist.pop_back();
+            const bb_t b = definition_blocks[instruct];
+            if(b != -1 && executable_blocks[b]) visit(*definitions[instruct], b);
+        }
+    }
+}
+
+const LatticeValue& ConstantPropagation::get(const instruct_t& instruct) const {
+    return values.at(instruct);
+}
+
+bool ConstantPropagation::is_executable(const bb_t& b) const {
+    return executable_blocks.at(b);
+}
+
+bool ConstantPropagation::is_executable(const bb_t& from, const bb_t& to) const {
+    return executable_edges.find({ from, to }) != executable_edges.end();
+}
+
+bb_t ConstantPropagation::get_branch_target(const bb_t& b) const {
+    const Instruction& branch_instruction = basic_blocks[b].branch_instruction;
+    if(!has_trait(branch_instruction.opcode, IS_BRANCH) || branch_instruction.opcode == Opcode::RET || branch_instruction.opcode == Opcode::END) return -1;
+    const instruct_t label = branch_instruction.opcode == Opcode::BRA ? branch_instruction.larg : branch_instruction.rarg;
+    auto it = labels.find(label);
+    return it == labels.end() ? -1 : it->second;
+}
+
+std::pair<bb_t, bb_t> ConstantPropagation::get_phi_predecessors(const bb_t& b) const {
+    const BasicBlock& block = basic_blocks[b];
+    // Loop headers get their right arguments from the (implicit) back edge.
+    if(block.branch_block != -1) return { block.predecessors.front(), block.branch_block };
+    return { block.predecessors.front(), block.predecessors.size() > 1 ? block.predecessors[1] : -1 };
+}
+
+LatticeValue ConstantPropagation::fold(Opcode op, const int& larg, const int& rarg) {
+    const long long left = larg;
+    const long long right = rarg;
+    long long result;
+    switch(op) {
+        case Opcode::ADD:
+            result = left + right;
+            break;
+        case Opcode::SUB:
+            result = left - right;
+            break;
+        case Opcode::MUL:
+            result = left * right;
+            break;
+        case Opcode::DIV:
+            // Leave traps for the program to hit at runtime.
+            if(right == 0 || (left == INT_MIN && right == -1)) return { LatticeValue::OVERDEFINED };
+            result = left / right;
+            break;
+        default:
+            return { LatticeValue::OVERDEFINED };
+    }
+    // Constants are ints, while the emitted code computes in 64 bits, so results that don't fit are left for runtime.
+    if(result < INT_MIN || result > INT_MAX) return { LatticeValue::OVERDEFINED };
+    return { LatticeValue::CONSTANT, static_cast<int>(result) };
+}
+
+bool ConstantPropagation::is_taken(Opcode op, const int& larg, const int& rarg) {
+    switch(op) {
+        case Opcode::BNE:
+            return larg != rarg;
+        case Opcode::BEQ:
+            return larg == rarg;
+        case Opcode::BLE:
+            return larg <= rarg;
+        case Opcode::BLT:
+            return larg < rarg;
+        case Opcode::BGE:
+            return larg >= rarg;
+        case Opcode::BGT:
+            return larg > rarg;
+        default:
+            return true;
+    }
+}
+
+LatticeValue ConstantPropagation::argument(const instruct_t& instruct) const {
+    if(instruct < 0 || instruct >= static_cast<instruct_t>(values.size())) return { LatticeValue::OVERDEFINED };
+    return values[instruct];
+}
+
+void ConstantPropagation::visit(const Instruction& instruction, const bb_t& b) {
+    if(has_trait(instruction.opcode, IS_BRANCH)) {
+        visit_branch(instruction, b);
+        return;
+    }
+    // Constants are known from the start.
+    if(instruction.opcode == Opcode::CONST) return;
+    const LatticeValue larg = argument(instruction.larg);
+    const LatticeValue rarg = argument(instruction.rarg);
+    if(instruction.opcode == Opcode::PHI) {
+        // Only arguments coming from edges that can be taken count.
+        LatticeValue value;
+        auto meet = [&](const LatticeValue& other) {
+            if(other.state == LatticeValue::UNDEFINED) return;
+            if(value.state == LatticeValue::UNDEFINED) value = other;
+            else if(value != other) value = { LatticeValue::OVERDEFINED };
+        };
+        const auto [left, right] = get_phi_predecessors(b);
+        if(is_executable(left, b)) meet(larg);
+        if(right != -1 && is_executable(right, b)) meet(rarg);
+        lower(instruction.instruction_number, value);
+    } else if(instruction.opcode == Opcode::CMP || has_trait(instruction.opcode, IS_CSE)) {
+        if(larg.state == LatticeValue::OVERDEFINED || rarg.state == LatticeValue::OVERDEFINED) {
+            lower(instruction.instruction_number, { LatticeValue::OVERDEFINED });
+        } else if(larg.state == LatticeValue::CONSTANT && rarg.state == LatticeValue::CONSTANT) {
+            // A comparison is constant when both of its arguments are (its branch does the comparing).
+            lower(instruction.instruction_number, instruction.opcode == Opcode::CMP ? LatticeValue{ LatticeValue::CONSTANT } : fold(instruction.opcode, larg.value, rarg.value));
+        }
+    } else if(has_trait(instruction.opcode, HAS_RESULT)) {
+        lower(instruction.instruction_number, { LatticeValue::OVERDEFINED });
+    }
+}
+
+void ConstantPropagation::visit_branch(const Instruction& branch_instruction, const bb_t& b) {
+    const std::pmr::vector<bb_t>& successors = basic_blocks[b].successors;
+    switch(branch_instruction.opcode) {
+        case Opcode::EMPTY:
+            for(const bb_t& successor : successors) mark_edge(b, successor);
+            return;
+        case Opcode::BRA:
+            mark_edge(b, get_branch_target(b));
+            return;
+        case Opcode::RET:
+        case Opcode::END:
+            return;
+        default:
+            break;
+    }
+
+    const instruct_t cmp = branch_instruction.larg;
+    const LatticeValue& condition = argument(cmp);
+    if(condition.state == LatticeValue::UNDEFINED) return;
+    const bb_t target = get_branch_target(b);
+    if(condition.state == LatticeValue::OVERDEFINED) {
+        for(const bb_t& successor : successors) mark_edge(b, successor);
+        return;
+    }
+    if(is_taken(branch_instruction.opcode, values[definitions[cmp]->larg].value, values[definitions[cmp]->rarg].value)) {
+        mark_edge(b, target);
+        return;
+    }
+    for(const bb_t& successor : successors) {
+        if(successor != target) mark_edge(b, successor);
+    }
+}
+
+void ConstantPropagation::visit_block(const bb_t& b) {
+    const BasicBlock& block = basic_blocks[b];
+    if(executable_blocks[b]) {
+        // Only the phi functions can see the new edge.
+        for(const Instruction& instruction : block.instructions) {
+            if(instruction.opcode == Opcode::PHI) visit(instruction, b);
+        }
+        return;
+    }
+    executable_blocks[b] = true;
+    for(const Instruction& instruction : block.instructions) visit(instruction, b);
+    visit_branch(block.branch_instruction, b);
+}
+
+void ConstantPropagation::mark_edge(const bb_t& from, const bb_t& to) {
+    if(to == -1) return;
+    if(executable_edges.insert({ from, to }).second) flow_worklist.emplace_back(from, to);
+}
+
+void ConstantPropagation::lower(const instruct_t& instruct, const LatticeValue& value) {
+    LatticeValue& current = values[instruct];
+    if(value.state == LatticeValue::UNDEFINED || current == value || current.state == LatticeValue::OVERDEFINED) return;
+    // Values only ever move down the lattice, so a second constant makes the value overdefined.
+    current = current.state == LatticeValue::CONSTANT ? LatticeValue{ LatticeValue::OVERDEFINED } : value;
+    for(const instruct_t& user : uses[instruct]) ssa_worklist.emplace_back(user);
+}
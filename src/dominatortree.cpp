@@ -0,0 +1,211 @@
+#include "dominatortree.hpp"
+#include <algorithm>
+#include <ranges>
+
+DominatorTree::DominatorTree() : idoms{0}, children(1), depths{0} {}
+
+void DominatorTree::compute(const std::pmr::vector<BasicBlock>& basic_blocks) {
+    const bb_t block_count = basic_blocks.size();
+    grow(block_count - 1);
+
+    // Postorder of the CFG from an iterative DFS starting at the const block. Back edges
+    // are implicit, so following successors never leaves a loop through its header.
+    std::vector<bb_t> order;
+    std::vector<ssize_t> postorder_numbers(block_count, -1);
+    std::vector<bool> visited(block_count, false);
+    std::vector<std::pair<bb_t, size_t>> stack{ { 0, 0 } };
+    visited[0] = true;
+    while(!stack.empty()) {
+        auto& [b, next] = stack.back();
+        if(next < basic_blocks[b].successors.size()) {
+            const bb_t successor = basic_blocks[b].successors[next++];
+            if(visited[successor]) continue;
+            visited[successor] = true;
+            stack.emplace_back(successor, 0);
+        } else {
+            postorder_numbers[b] = order.size();
+            order.emplace_back(b);
+            stack.pop_back();
+        }
+    }
+
+    // Cooper-Harvey-Kennedy
+    // Iterative Reverse Postorder Dominance Algorithm
+    std::vector<bb_t> new_idoms(block_count, -1);
+    new_idoms[0] = 0;
+    auto meet = [&](bb_t b1, bb_t b2) {
+        while(b1 != b2) {
+            while(postorder_numbers[b1] < postorder_numbers[b2]) b1 = new_idoms[b1];
+            while(postorder_numbers[b2] < postorder_numbers[b1]) b2 = new_idoms[b2];
+        }
+        return b1;
+    };
+    bool changed = true;
+    while(changed) {
+        changed = false;
+        for(const bb_t& b : order | std::views::reverse | std::views::drop(1)) {
+            bb_t new_idom = -1;
+            auto visit = [&](const bb_t& predecessor) {
+                if(new_idoms[predecessor] == -1) return;
+                new_idom = new_idom == -1 ? predecessor : meet(predecessor, new_idom);
+            };
+            for(const bb_t& predecessor : basic_blocks[b].predecessors) visit(predecessor);
+            if(basic_blocks[b].branch_block != -1) visit(basic_blocks[b].branch_block);
+            if(new_idoms[b] != new_idom) {
+                new_idoms[b] = new_idom;
+                changed = true;
+            }
+        }
+    }
+
+    // Rebuild the tree in reverse postorder so a block's immediate dominator is always placed first.
+    idoms = std::move(new_idoms);
+    for(auto& block_children : children) block_children.clear();
+    for(const bb_t& b : order | std::views::reverse | std::views::drop(1)) {
+        children[idoms[b]].emplace_back(b);
+        depths[b] = depths[idoms[b]] + 1;
+    }
+    numbered = false;
+}
+
+void DominatorTree::add_block(const bb_t& b, const bb_t& idom) {
+    grow(b);
+    attach(b, idom);
+}
+
+void DominatorTree::set_idom(const bb_t& b, const bb_t& idom) {
+    detach(b);
+    attach(b, idom);
+}
+
+void DominatorTree::insert_blocks(const bb_t& position, const size_t& count) {
+    auto shift = [&](bb_t& b) {
+        if(b >= position) b += count;
+    };
+    for(bb_t& idom : idoms) shift(idom);
+    for(auto& block_children : children) {
+        for(bb_t& child : block_children) shift(child);
+    }
+    idoms.insert(idoms.begin() + position, count, -1);
+    children.insert(children.begin() + position, count, {});
+    depths.insert(depths.begin() + position, count, 0);
+    numbered = false;
+}
+
+void DominatorTree::split_block(const bb_t& b, const bb_t& tail) {
+    grow(tail);
+    children[tail] = std::move(children[b]);
+    children[b].clear();
+    for(const bb_t& child : children[tail]) idoms[child] = tail;
+    attach(tail, b);
+}
+
+void DominatorTree::merge_block(const bb_t& b) {
+    const bb_t idom = idoms[b];
+    std::vector<bb_t> moved = std::move(children[b]);
+    children[b].clear();
+    detach(b);
+    for(const bb_t& child : moved) attach(child, idom);
+}
+
+bb_t DominatorTree::intersect(bb_t b1, bb_t b2) const {
+    while(b1 != b2) {
+        if(depths[b1] >= depths[b2]) b1 = idoms[b1];
+        else b2 = idoms[b2];
+    }
+    return b1;
+}
+
+bool DominatorTree::dominates(const bb_t& a, const bb_t& b) const {
+    if(idoms.at(a) == -1 || idoms.at(b) == -1) return a == b;
+    number();
+    return preorder[a] <= preorder[b] && postorder[b] <= postorder[a];
+}
+
+bool DominatorTree::strictly_dominates(const bb_t& a, const bb_t& b) const {
+    return a != b && dominates(a, b);
+}
+
+std::vector<std::vector<bb_t>> DominatorTree::dominance_frontiers(const std::pmr::vector<BasicBlock>& basic_blocks) const {
+    std::vector<std::vector<bb_t>> frontiers(basic_blocks.size());
+    for(const BasicBlock& block : basic_blocks) {
+        std::vector<bb_t> predecessors(block.predecessors.begin(), block.predecessors.end());
+        if(block.branch_block != -1) predecessors.emplace_back(block.branch_block);
+        if(predecessors.size() < 2 || idoms[block.index] == -1) continue;
+        // Walk up from each predecessor until reaching the block's immediate dominator.
+        for(bb_t runner : predecessors) {
+            if(idoms[runner] == -1) continue;
+            while(runner != idoms[block.index]) {
+                if(!frontiers[runner].empty() && frontiers[runner].back() == block.index) break;
+                frontiers[runner].emplace_back(block.index);
+                runner = idoms[runner];
+            }
+        }
+    }
+    return frontiers;
+}
+
+const bb_t& DominatorTree::get_idom(const bb_t& b) const {
+    return idoms.at(b);
+}
+
+const std::vector<bb_t>& DominatorTree::get_children(const bb_t& b) const {
+    return children.at(b);
+}
+
+size_t DominatorTree::get_depth(const bb_t& b) const {
+    return depths.at(b);
+}
+
+size_t DominatorTree::size() const {
+    return idoms.size();
+}
+
+void DominatorTree::number() const {
+    if(numbered) return;
+    preorder.assign(idoms.size(), 0);
+    postorder.assign(idoms.size(), 0);
+    size_t preorder_count = 0;
+    size_t postorder_count = 0;
+    std::vector<std::pair<bb_t, size_t>> stack{ { 0, 0 } };
+    preorder[0] = preorder_count++;
+    while(!stack.empty()) {
+        auto& [b, next] = stack.back();
+        if(next < children[b].size()) {
+            const bb_t child = children[b][next++];
+            preorder[child] = preorder_count++;
+            stack.emplace_back(child, 0);
+        } else {
+            postorder[b] = postorder_count++;
+            stack.pop_back();
+        }
+    }
+    numbered = true;
+}
+
+void DominatorTree::grow(const bb_t& b) {
+    if(b < static_cast<bb_t>(idoms.size())) return;
+    idoms.resize(b + 1, -1);
+    children.resize(b + 1);
+    depths.resize(b + 1, 0);
+}
+
+void DominatorTree::detach(const bb_t& b) {
+    if(b == 0 || idoms[b] == -1) return;
+    std::erase(children[idoms[b]], b);
+    idoms[b] = -1;
+}
+
+void DominatorTree::attach(const bb_t& b, const bb_t& idom) {
+    idoms[b] = idom;
+    children[idom].emplace_back(b);
+    // Every block dominated by the given block moves along with it.
+    std::vector<bb_t> stack{ b };
+    while(!stack.empty()) {
+        const bb_t curr_block = stack.back();
+        stack.pop_back();
+        depths[curr_block] = depths[idoms[curr_block]] + 1;
+        for(const bb_t& child : children[curr_block]) stack.emplace_back(child);
+    }
+    numbered = false;
+}
@@ -0,0 +1,55 @@
+#include "identifiermap.hpp"
+#include <type_traits>
+
+IdentifierMap::IdentifierMap() {}
+
+IdentifierMap::IdentifierMap(const ident_t& size, const instruct_t& fill, const instruct_t& fill_step, std::pmr::memory_resource* resource)
+    : identifier_count(size), fill(fill), fill_step(fill_step), resource(resource) {
+    while((static_cast<ident_t>(1) << (BITS * (height + 1))) < identifier_count) ++height;
+}
+
+instruct_t IdentifierMap::get(const ident_t& ident) const {
+    if(ident < 0 || ident >= identifier_count) return -1;
+    const Branch* branch = root.get();
+    for(ident_t level = height; level > 1 && branch; --level) {
+        branch = branch->branches[(ident >> (BITS * level)) & MASK].get();
+    }
+    if(!branch) return fill_value(ident);
+    const Leaf* leaf = branch->leaves[(ident >> BITS) & MASK].get();
+    if(!leaf) return fill_value(ident);
+    return leaf->values[ident & MASK];
+}
+
+void IdentifierMap::set(const ident_t& ident, const instruct_t& value) {
+    // Copy every node on the path that's shared with another map (or create it if it doesn't exist yet).
+    auto own = [&](auto& node) {
+        using Node = typename std::remove_reference_t<decltype(node)>::element_type;
+        std::pmr::polymorphic_allocator<Node> alloc(resource);
+        if(!node) node = std::allocate_shared<Node>(alloc);
+        else if(node.use_count() > 1) node = std::allocate_shared<Node>(alloc, *node);
+    };
+    own(root);
+    Branch* branch = root.get();
+    for(ident_t level = height; level > 1; --level) {
+        std::shared_ptr<Branch>& child = branch->branches[(ident >> (BITS * level)) & MASK];
+        own(child);
+        branch = child.get();
+    }
+    std::shared_ptr<Leaf>& leaf = branch->leaves[(ident >> BITS) & MASK];
+    if(!leaf) {
+        leaf = std::allocate_shared<Leaf>(std::pmr::polymorphic_allocator<Leaf>(resource));
+        const ident_t base = ident & ~MASK;
+        for(ident_t i = 0; i < WIDTH; ++i) leaf->values[i] = fill_value(base + i);
+    } else {
+        own(leaf);
+    }
+    leaf->values[ident & MASK] = value;
+}
+
+ident_t IdentifierMap::size() const {
+    return identifier_count;
+}
+
+instruct_t IdentifierMap::fill_value(const ident_t& ident) const {
+    return fill - ident * fill_step;
+}
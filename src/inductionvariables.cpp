@@ -0,0 +1,70 @@
+#include "inductionvariables.hpp"
+#include <climits>
+#include <map>
+
+InductionVariables::InductionVariables(const std::pmr::vector<BasicBlock>& basic_blocks, const std::pmr::unordered_map<instruct_t, int>& const_instructions, const Loop& loop) {
+    std::unordered_map<instruct_t, std::pair<const Instruction*, bb_t>> definitions;
+    for(const bb_t& b : loop.blocks) {
+        for(const Instruction& instruction : basic_blocks[b].instructions) {
+            variants.insert(instruction.instruction_number);
+            definitions[instruction.instruction_number] = { &instruction, b };
+        }
+    }
+    auto const_value = [&](const instruct_t& instruct) -> const int* {
+        auto it = const_instructions.find(instruct);
+        return it == const_instructions.end() ? nullptr : &it->second;
+    };
+
+    // Basic induction variables: phi + constant, constant + phi or phi - constant.
+    for(const Instruction& phi : basic_blocks[loop.header].instructions) {
+        if(phi.opcode != Opcode::PHI) break;
+        auto it = definitions.find(phi.rarg);
+        if(it == definitions.end()) continue;
+        const auto& [increment, increment_block] = it->second;
+        const int* step = nullptr;
+        if(increment->opcode == Opcode::ADD && increment->larg == phi.instruction_number) step = const_value(increment->rarg);
+        else if(increment->opcode == Opcode::ADD && increment->rarg == phi.instruction_number) step = const_value(increment->larg);
+        else if(increment->opcode == Opcode::SUB && increment->larg == phi.instruction_number) step = const_value(increment->rarg);
+        if(!step || (increment->opcode == Opcode::SUB && *step == INT_MIN)) continue;
+        basic.push_back({ phi.instruction_number, phi.larg, increment->instruction_number, increment_block,
+                          increment->opcode == Opcode::SUB ? -*step : *step });
+    }
+    if(basic.empty()) return;
+
+    // Derived induction variables, keyed by their basic induction variable and factor.
+    std::unordered_map<instruct_t, std::pair<size_t, bool>> operands; // Maps to (basic, is the increment).
+    for(size_t i = 0; i < basic.size(); ++i) {
+        operands[basic[i].phi] = { i, false };
+        operands[basic[i].increment] = { i, true };
+    }
+    std::map<std::pair<size_t, instruct_t>, size_t> indices;
+    for(const bb_t& b : loop.blocks) {
+        for(const Instruction& instruction : basic_blocks[b].instructions) {
+            if(instruction.opcode != Opcode::MUL) continue;
+            auto it = operands.find(instruction.larg);
+            instruct_t factor = instruction.rarg;
+            if(it == operands.end() || !is_invariant(factor)) {
+                it = operands.find(instruction.rarg);
+                factor = instruction.larg;
+            }
+            if(it == operands.end() || !is_invariant(factor)) continue;
+            const auto& [index, of_increment] = it->second;
+            auto [entry, inserted] = indices.try_emplace({ index, factor }, derived.size());
+            if(inserted) derived.push_back({ index, factor, {}, {} });
+            DerivedInductionVariable& variable = derived[entry->second];
+            (of_increment ? variable.increment_products : variable.phi_products).emplace_back(instruction.instruction_number);
+        }
+    }
+}
+
+const std::vector<InductionVariable>& InductionVariables::get_basic() const {
+    return basic;
+}
+
+const std::vector<DerivedInductionVariable>& InductionVariables::get_derived() const {
+    return derived;
+}
+
+bool InductionVariables::is_invariant(const instruct_t& instruct) const {
+    return variants.find(instruct) == variants.end();
+}
@@ -0,0 +1,85 @@
+#include "instructionlist.hpp"
+
+InstructionList::InstructionList(const allocator_type& alloc) : nodes(alloc) {}
+
+InstructionList::InstructionList(const InstructionList& other, const allocator_type& alloc)
+    : nodes(other.nodes, alloc), head(other.head), tail(other.tail), free_list(other.free_list), count(other.count) {}
+
+InstructionList::InstructionList(InstructionList&& other, const allocator_type& alloc)
+    : nodes(std::move(other.nodes), alloc), head(other.head), tail(other.tail), free_list(other.free_list), count(other.count) {}
+
+InstructionList::iterator InstructionList::insert(const_iterator pos, const Instruction& instruction) {
+    handle_t node;
+    if(free_list != NIL) {
+        node = free_list;
+        free_list = nodes[node].next;
+        nodes[node].instruction = instruction;
+    } else {
+        node = nodes.size();
+        nodes.push_back({ instruction, NIL, NIL });
+    }
+    const handle_t next = pos.handle();
+    const handle_t prev = next == NIL ? tail : nodes[next].prev;
+    nodes[node].prev = prev;
+    nodes[node].next = next;
+    if(prev == NIL) head = node;
+    else nodes[prev].next = node;
+    if(next == NIL) tail = node;
+    else nodes[next].prev = node;
+    ++count;
+    return { this, node };
+}
+
+InstructionList::iterator InstructionList::erase(const_iterator pos) {
+    const handle_t node = pos.handle();
+    const handle_t prev = nodes[node].prev;
+    const handle_t next = nodes[node].next;
+    if(prev == NIL) head = next;
+    else nodes[prev].next = next;
+    if(next == NIL) tail = prev;
+    else nodes[next].prev = prev;
+    nodes[node].next = free_list;
+    free_list = node;
+    --count;
+    return { this, next };
+}
+
+void InstructionList::push_back(const Instruction& instruction) {
+    insert(end(), instruction);
+}
+
+void InstructionList::push_front(const Instruction& instruction) {
+    insert(begin(), instruction);
+}
+
+Instruction& InstructionList::get(const handle_t& handle) {
+    return nodes.at(handle).instruction;
+}
+
+const Instruction& InstructionList::get(const handle_t& handle) const {
+    return nodes.at(handle).instruction;
+}
+
+Instruction& InstructionList::front() {
+    return nodes[head].instruction;
+}
+
+const Instruction& InstructionList::front() const {
+    return nodes[head].instruction;
+}
+
+Instruction& InstructionList::back() {
+    return nodes[tail].instruction;
+}
+
+const Instruction& InstructionList::back() const {
+    return nodes[tail].instruction;
+}
+
+size_t InstructionList::size() const {
+    return count;
+}
+
+bool InstructionList::empty() const {
+    return count == 0;
+}
@@ -1,87 +1,90 @@
 #include "intermediaterepresentation.hpp"
+#include "interpreter.hpp"
 #include <algorithm>
+#include <climits>
+#include <cstdlib>
 #include <map>
 #include <ranges>
 #include <format>
 #include <iostream>
 #include <stdexcept>
-
-IntermediateRepresentation::IntermediateRepresentation() : basic_blocks{0}, doms{0} {} 
+#include <tuple>
+
+IntermediateRepresentation::IntermediateRepresentation()
+    : arena(std::make_unique<Arena>()), basic_blocks(arena->resource()),
+      allocation_analyses(std::make_unique<AllocationAnalyses>()), const_instructions(arena->resource()), assigned_registers(arena->resource()), death_points(arena->resource()),
+      loop_phis(arena->resource()), memoized_functions(arena->resource()), outputs(arena->resource()), phi_owners(arena->resource()) {
+    basic_blocks.emplace_back(0);
+    const_instructions[0] = 0;
+    // The const block is the root of the dominator tree, so its scope is always open.
+    value_table.enter_scope(0);
+    record_value(0, basic_blocks[0].instructions.front());
+} 
 
 void IntermediateRepresentation::init_live_ins() {
-    live_ins.assign(basic_blocks.size(), std::unordered_set<instruct_t>());
+    allocation_analyses->live_ins.assign(basic_blocks.size(), std::pmr::unordered_set<instruct_t>());
 }
 
-// Cooper-Harvey-Kennedy 
-// Iterative Reverse Postorder Dominance Algorithm
-// This algorithm is implicitly ran just for new blocks that are added to the data structure.
-// Only run this if the whole thing needs to be recalculated for some reason.
 void IntermediateRepresentation::compute_dominators() {
     if(ignore) return;
-    std::ranges::fill(doms, -1);
-    doms[0] = basic_blocks[0].index; // entry block
-    bool changed = true;
-    while (changed) {
-        changed = false;
-        // for all basic_blocks, b, in reverse postorder (except first basic block)
-        for (const BasicBlock &b : basic_blocks | std::views::drop(1)) {
-            int new_idom = b.predecessors.front();
-            // if b has a second predecessor
-            if (b.predecessors.size() == 2 && doms[b.predecessors.back()] != -1) {
-                new_idom = intersect(b.predecessors.back(), new_idom);
-            }
-            if (doms[b.index] != new_idom) {
-                doms[b.index] = new_idom;
-                changed = true;
-            }
-        }
-    }
+    dom_tree.compute(basic_blocks);
+    dominance_frontiers.reset();
 }
 
 bb_t IntermediateRepresentation::intersect(bb_t b1, bb_t b2) const {
     if(ignore) return -1;
-    while(b1 != b2) {
-        while(b1 > b2) b1 = doms[b1];
-        while(b2 > b1) b2 = doms[b2];
-    }
-    return b1;
+    return dom_tree.intersect(b1, b2);
+}
+
+bool IntermediateRepresentation::dominates(const bb_t& a, const bb_t& b) const {
+    return dom_tree.dominates(a, b);
 }
 
 bb_t IntermediateRepresentation::new_function(const bb_t& idom, const ident_t& ident_count) {
+    reset_cfg_analyses();
     bb_t index = basic_blocks.size();
     basic_blocks.emplace_back(index, ident_count, idom);
     basic_blocks[0].successors.emplace_back(index);
-    doms.push_back(idom);
+    dom_tree.add_block(index, idom);
     return index;
 }
 
 bb_t IntermediateRepresentation::new_block_helper(const bb_t& p1, const bb_t& p2, const bb_t& idom, Blocktype t) {
     if(ignore) return -1;
+    reset_cfg_analyses();
     bb_t index = basic_blocks.size();
     if(t == Blocktype::LOOP_HEADER) {
-        basic_blocks.emplace_back(index, basic_blocks[p1].identifier_values, p1, Blocktype::INVALID);
+        // Phi functions are only created for identifiers that are read inside of the loop (see resolve_value)
+        // or that have changed by the time the loop is finished (see update_phi). Until then, every identifier's
+        // value in the loop header is a marker standing in for its phi function.
+        const ident_t ident_count = basic_blocks[p1].identifier_values.size();
+        loop_marker_bases.emplace_back(index, marker_count);
+        marker_count += ident_count;
+        basic_blocks.emplace_back(index, IdentifierMap(ident_count, loop_marker(index, 0), 1, arena->resource()), p1, Blocktype::INVALID);
         basic_blocks[p1].successors.emplace_back(index);
-        for(ident_t ident = 0; ident < static_cast<ssize_t>(basic_blocks[index].identifier_values.size()); ++ident) {
-            instruct_t phi_instruct = add_instruction(index, Opcode::PHI, { basic_blocks[index].identifier_values[ident], ident }, { -1, -1});
-            change_ident_value(index, ident, phi_instruct);
-        }
     } else if(t != Blocktype::INVALID) { // New block has 1 parent, and either FALLTHROUGH or BRANCH Blocktype.
         basic_blocks.emplace_back(index, basic_blocks[p1].identifier_values, p1, t);
         basic_blocks[p1].successors.emplace_back(index);
     }
     else if(p2 != -1) { // New block has 2 parents, and is guaranteed to have the JOIN Blocktype.
-        basic_blocks.emplace_back(index, p1, p2, Blocktype::JOIN);
+        basic_blocks.emplace_back(index, basic_blocks[p1].identifier_values, p1, p2, Blocktype::JOIN);
         basic_blocks[p1].successors.emplace_back(index);
         basic_blocks[p2].successors.emplace_back(index);
-        // Generate phi functions for conflicting identifier values.
-        for(size_t i = 0; i < basic_blocks[p1].identifier_values.size(); ++i) {
-            if(basic_blocks[p1].identifier_values[i] != basic_blocks[p2].identifier_values[i]) {
-                add_instruction(index, Opcode::PHI, { basic_blocks[p1].identifier_values[i], i }, { basic_blocks[p2].identifier_values[i], i });
-                basic_blocks[index].identifier_values.emplace_back(instruction_count);
-            } 
-            else {
-                basic_blocks[index].identifier_values.emplace_back(basic_blocks[p1].identifier_values[i]);
+        // Generate phi functions for conflicting identifier values. The join starts out sharing the first
+        // parent's values, so only the identifiers whose values differ between the parents are visited.
+        std::vector<std::tuple<ident_t, instruct_t, instruct_t>> conflicts;
+        basic_blocks[p1].identifier_values.for_each_difference(basic_blocks[p2].identifier_values, [&](const ident_t& ident, const instruct_t& v1, const instruct_t& v2) {
+            conflicts.emplace_back(ident, v1, v2);
+        });
+        for(const auto& [ident, v1, v2] : conflicts) {
+            if(peek_value(v1) == peek_value(v2)) {
+                change_ident_value(index, ident, peek_value(v1));
+                continue;
             }
+            // Resolving a marker may create a phi function in a loop header, so resolve both before adding this one.
+            const instruct_t larg = resolve_value(v1);
+            const instruct_t rarg = resolve_value(v2);
+            change_ident_value(index, ident, add_instruction(index, Opcode::PHI, { larg, ident }, { rarg, ident }));
         }
     }
     else { // New block has 1 parent and no specified Blocktype, so it'll be assigned the NONE Blocktype.
@@ -92,10 +95,10 @@ bb_t IntermediateRepresentation::new_block_helper(const bb_t& p1, const bb_t& p2
     // Either the new_block function is called with 2 parents and a specified immediate dominator,
     // or the new_block function is called with 1 parent (which will trivially be its immediate dominator).
     if(idom != -1) {
-        doms.push_back(idom);
+        dom_tree.add_block(index, idom);
     }
     else {
-        doms.push_back(p1);
+        dom_tree.add_block(index, p1);
     }
     return index;
 } 
@@ -117,15 +120,12 @@ bb_t IntermediateRepresentation::new_block(const bb_t& p1, const bb_t& p2, const
 
 instruct_t IntermediateRepresentation::change_empty(const bb_t& b, Opcode op, const instruct_t& larg, const instruct_t& rarg) {
     if(ignore) return -1;
-    if(basic_blocks[b].instructions.size() != 0 && basic_blocks[b].instructions.front().opcode == Opcode::EMPTY) {
+    if(basic_blocks[b].instructions.size() == 1 && basic_blocks[b].instructions.front().opcode == Opcode::EMPTY) {
         Instruction& instruction = basic_blocks[b].instructions.front();
         instruction.opcode = op;
         instruction.larg = larg;
         instruction.rarg = rarg;
-        if(op < CSE_COUNT) {
-            basic_blocks[b].partitioned_instructions[op].emplace_back(basic_blocks[b].empty_index);
-            basic_blocks[b].empty_index = -1;
-        }
+        record_value(b, instruction);
         return instruction.instruction_number;
     }
     return -1;
@@ -133,17 +133,13 @@ instruct_t IntermediateRepresentation::change_empty(const bb_t& b, Opcode op, co
 
 instruct_t IntermediateRepresentation::change_empty(const bb_t& b, Opcode op, const std::pair<instruct_t, ident_t>& larg, const std::pair<instruct_t, ident_t>& rarg) {
     if(ignore) return -1;
-    if(basic_blocks[b].instructions.size() != 0 && basic_blocks[b].instructions.front().opcode == Opcode::EMPTY) {
+    if(basic_blocks[b].instructions.size() == 1 && basic_blocks[b].instructions.front().opcode == Opcode::EMPTY) {
         Instruction& instruction = basic_blocks[b].instructions.front();
         instruction.opcode = op;
         instruction.larg = larg.first;
         instruction.rarg = rarg.first;
-        instruction.larg_owner = larg.second;
-        instruction.rarg_owner = rarg.second;
-        if(op < CSE_COUNT) {
-            basic_blocks[b].partitioned_instructions[op].emplace_back(basic_blocks[b].empty_index);
-            basic_blocks[b].empty_index = -1;
-        }
+        if(op == Opcode::PHI) phi_owners[instruction.instruction_number] = larg.second;
+        record_value(b, instruction);
         return instruction.instruction_number;
     }
     return -1;
@@ -161,12 +157,15 @@ instruct_t IntermediateRepresentation::add_instruction_helper(const bb_t& b, Opc
 
     // Whether we want to append (to the end) or prepend (at the beginning) the new instruction.
     if(prepend) {
-        basic_blocks[b].prepend_instruction(++instruction_count, op, larg.first, rarg.first, larg.second, rarg.second);  
+        basic_blocks[b].prepend_instruction(++instruction_count, op, larg.first, rarg.first);  
+        record_value(b, basic_blocks[b].instructions.front());
     } else {
-        basic_blocks[b].add_instruction(++instruction_count, op, larg.first, rarg.first, larg.second, rarg.second);  
+        basic_blocks[b].add_instruction(++instruction_count, op, larg.first, rarg.first);  
+        record_value(b, basic_blocks[b].instructions.back());
     }
     if(op == Opcode::CONST) const_instructions[instruction_count] = larg.first;
-    // Not only place phis can be made. Check update_phis/generate_phis function too!
+    if(op == Opcode::PHI) phi_owners[instruction_count] = larg.second;
+    // Not only place phis can be made. Check the update_phi function too!
     if(op == Opcode::PHI && rarg.first != -1) establish_affinity_group(instruction_count, larg.first, rarg.first);
     return instruction_count;
 }
@@ -227,7 +226,6 @@ void IntermediateRepresentation::set_branch_cond(const bb_t& b, Opcode op, const
     if(instruction.instruction_number == -1) instruction.instruction_number = ++instruction_count;
     instruction.opcode = op;
     instruction.larg = larg.first;
-    instruction.larg_owner = larg.second;
     if(op == Opcode::RET) set_return(b);
 }
 
@@ -239,201 +237,1635 @@ void IntermediateRepresentation::set_branch_location(const bb_t& b, const instru
 
 instruct_t IntermediateRepresentation::search_cse(const bb_t& b, Opcode op, const instruct_t& larg, const instruct_t& rarg) {
     if(ignore) return -1;
-    if(while_loop && op != Opcode::CONST) return -1;
-    if(op > CSE_COUNT) return -1;
-    bb_t curr_block = b;
-    while(true) {
-        for(const int& instruct : basic_blocks[curr_block].partitioned_instructions[op]) {
-            if(op == basic_blocks[curr_block].instructions[instruct].opcode &&
-               larg == basic_blocks[curr_block].instructions[instruct].larg &&
-               rarg == basic_blocks[curr_block].instructions[instruct].rarg)
-            return basic_blocks[curr_block].instructions[instruct].instruction_number;
+    if(!has_trait(op, IS_CSE)) return -1;
+    if(!value_table.in_scope(b)) enter_value_scope(b);
+    return value_table.lookup(b, ValueKey(op, larg, rarg));
+}
+
+void IntermediateRepresentation::enter_value_scope(const bb_t& b) {
+    // Blocks on the way up the dominator tree whose scopes aren't open yet.
+    std::vector<bb_t> path;
+    for(bb_t curr_block = b; !value_table.in_scope(curr_block); curr_block = dom_tree.get_idom(curr_block)) {
+        path.emplace_back(curr_block);
+    }
+    const bb_t ancestor = path.empty() ? b : dom_tree.get_idom(path.back());
+    while(value_table.current_scope() != ancestor) value_table.leave_scope();
+    for(const bb_t& block : path | std::views::reverse) {
+        value_table.enter_scope(block);
+        for(const Instruction& instruction : basic_blocks[block].instructions) {
+            if(!has_trait(instruction.opcode, IS_CSE)) continue;
+            value_table.insert(block, ValueKey(instruction.opcode, instruction.larg, instruction.rarg), instruction.instruction_number);
         }
-        if(curr_block == 0) return -1;
-        curr_block = doms[curr_block];
     }
 }
 
-     
-void IntermediateRepresentation::commit_while(const bb_t& curr_block, const bb_t& loop_header, const bb_t& branch_back, std::map<std::string, ident_t>& identifier_table) {
+void IntermediateRepresentation::record_value(const bb_t& b, const Instruction& instruction) {
+    if(!has_trait(instruction.opcode, IS_CSE)) return;
+    if(!value_table.in_scope(b)) enter_value_scope(b);
+    value_table.insert(b, ValueKey(instruction.opcode, instruction.larg, instruction.rarg), instruction.instruction_number);
+}
+
+void IntermediateRepresentation::forget_value(const Instruction& instruction) {
+    if(!has_trait(instruction.opcode, IS_CSE)) return;
+    value_table.erase(ValueKey(instruction.opcode, instruction.larg, instruction.rarg), instruction.instruction_number);
+}
+
+void IntermediateRepresentation::set_arguments(const bb_t& b, Instruction& instruction, const instruct_t& larg, const instruct_t& rarg) {
+    if(instruction.larg == larg && instruction.rarg == rarg) return;
+    // Only blocks whose scopes are open have their instructions in the value table. The others are
+    // recorded with their current arguments once their scopes are entered again.
+    const bool recorded = value_table.in_scope(b);
+    if(recorded) forget_value(instruction);
+    instruction.larg = larg;
+    instruction.rarg = rarg;
+    if(recorded) record_value(b, instruction);
+}
+
+
+void IntermediateRepresentation::commit_while(const bb_t& loop_header, const bb_t& branch_back) {
     if(ignore) return;
-    // PHI affinity groups
-    if(is_loop_header(curr_block)) {
-        for(const auto& instruction : basic_blocks[curr_block].instructions) {
-            if(instruction.opcode == Opcode::DELETED) continue;
-            if(instruction.opcode != Opcode::PHI) break;
-            establish_affinity_group(instruction.instruction_number, instruction.larg, instruction.rarg);
-        }
-    }
-    // CSE
-    for(int op = 0; op < Opcode::CSE_COUNT; op += 1) {
-        for(const int& instruct : basic_blocks[curr_block].partitioned_instructions[op] | std::views::reverse) {
-            instruct_t copy = search_cse(curr_block, basic_blocks[curr_block].instructions[instruct].opcode, 
-                                      basic_blocks[curr_block].instructions[instruct].larg,
-                                      basic_blocks[curr_block].instructions[instruct].rarg);
-            if(copy != -1 && copy != basic_blocks[curr_block].instructions[instruct].instruction_number) {
-                basic_blocks[curr_block].instructions[instruct].opcode = Opcode::DELETED;
-                // Replace identifier table values
-                for(auto& pair : identifier_table) {
-                    if(pair.second == basic_blocks[curr_block].instructions[instruct].instruction_number) pair.second = copy;
-                }
-                cse_replace(loop_header, branch_back, copy, basic_blocks[curr_block].instructions[instruct].instruction_number);
-            }
-            copy = search_cse(doms[curr_block], basic_blocks[curr_block].instructions[instruct].opcode, 
-                                      basic_blocks[curr_block].instructions[instruct].larg,
-                                      basic_blocks[curr_block].instructions[instruct].rarg);
-            if(copy != -1 && copy != basic_blocks[curr_block].instructions[instruct].instruction_number) {
-                basic_blocks[curr_block].instructions[instruct].opcode = Opcode::DELETED;
-                // Replace identifier table values
-                for(auto& pair : identifier_table) {
-                    if(pair.second == basic_blocks[curr_block].instructions[instruct].instruction_number) pair.second = copy;
-                }
-                cse_replace(loop_header, branch_back, copy, basic_blocks[curr_block].instructions[instruct].instruction_number);
+    if(will_return(branch_back)) return;
+    const std::vector<bb_t> loop = LoopForest::natural_loop(basic_blocks, loop_header);
+
+    // PHI affinity groups (every nested loop's phis are final once the outermost loop is done)
+    if(!while_loop) {
+        for(const bb_t& b : loop) {
+            if(!is_loop_header(b)) continue;
+            for(const auto& instruction : basic_blocks[b].instructions) {
+                if(instruction.opcode != Opcode::PHI) break;
+                establish_affinity_group(instruction.instruction_number, instruction.larg, instruction.rarg);
             }
         }
     }
-    if(curr_block == branch_back) return;
-    for(const auto& successor : basic_blocks[curr_block].successors) {
-        commit_while(successor, loop_header, branch_back, identifier_table);
+
+    // The block entering the loop only falls through to the loop header, which makes it the preheader.
+    const bb_t preheader = basic_blocks[loop_header].predecessors.front();
+    const bool can_hoist = has_one_successor(preheader) && !has_branch_instruction(preheader) && !will_return(preheader);
+
+    // Instructions of the loop that were deleted, mapped to the instruction that replaces them.
+    std::unordered_map<instruct_t, instruct_t> replacements;
+    // Values defined in the loop that may change between iterations.
+    std::unordered_set<instruct_t> variants;
+    auto replacement = [&](const instruct_t& instruct) {
+        auto it = replacements.find(instruct);
+        return it == replacements.end() ? instruct : it->second;
+    };
+    auto is_invariant = [&](const instruct_t& instruct) {
+        return variants.find(instruct) == variants.end();
+    };
+
+    // The loop's blocks are visited in dominator order, so (phis aside) an instruction's arguments
+    // have always been visited, and possibly replaced, before the instruction itself.
+    for(const bb_t& b : loop) {
+        for(auto it = basic_blocks[b].instructions.begin(); it != basic_blocks[b].instructions.end();) {
+            Instruction& instruction = *it;
+            set_arguments(b, instruction, replacement(instruction.larg), replacement(instruction.rarg));
+            if(!has_trait(instruction.opcode, IS_CSE)) {
+                variants.insert(instruction.instruction_number);
+                ++it;
+                continue;
+            }
+
+            // CSE (an instruction finds itself first if it's the block's oldest definition)
+            instruct_t copy = search_cse(b, instruction.opcode, instruction.larg, instruction.rarg);
+            if(copy == instruction.instruction_number) {
+                copy = search_cse(dom_tree.get_idom(b), instruction.opcode, instruction.larg, instruction.rarg);
+            }
+            if(copy != -1 && copy != instruction.instruction_number) {
+                forget_value(instruction);
+                replacements[instruction.instruction_number] = copy;
+                it = remove_instruction(b, it);
+                continue;
+            }
+
+            // LICM (the preheader runs even when the loop body doesn't, so only hoist what can't trap)
+            if(can_hoist && is_invariant(instruction.larg) && is_invariant(instruction.rarg) && is_safe_to_hoist(instruction)) {
+                forget_value(instruction);
+                replacements[instruction.instruction_number] = add_instruction(preheader, instruction.opcode, instruction.larg, instruction.rarg);
+                it = remove_instruction(b, it);
+                continue;
+            }
+            variants.insert(instruction.instruction_number);
+            ++it;
+        }
     }
-}
+    if(replacements.empty()) return;
+
+    // Phi functions, returns and blocks that return from inside of the loop can use values that were
+    // replaced after they were visited.
+    replace_uses(loop_header, replacements);
+}
+
+bb_t IntermediateRepresentation::unswitch_loop(const bb_t& loop_header, const bb_t& branch_back) {
+    if(ignore || will_return(branch_back)) return -1;
+    // The preheader falls through to the header, and the loop's blocks are the last ones created.
+    const bb_t preheader = basic_blocks[loop_header].predecessors.front();
+    const bb_t last = basic_blocks.size() - 1;
+    if(preheader != loop_header - 1 || has_branch_instruction(preheader)) return -1;
+    size_t size = 0;
+    for(bb_t b = loop_header; b <= last; ++b) {
+        size += basic_blocks[b].instructions.size();
+        // Calls to functions that aren't declared yet are fixed up once they are, which would miss the loop's copy.
+        if(std::ranges::any_of(basic_blocks[b].instructions, [](const Instruction& instruction) {
+            return instruction.opcode == Opcode::JSR && instruction.larg == -1;
+        })) return -1;
+    }
+    if(size > UNSWITCH_BUDGET) return -1;
 
-void IntermediateRepresentation::cse_replace(const bb_t& curr_block, const bb_t& branch_back, const instruct_t& replacer, const instruct_t& to_delete) {
-    // Search CFG
-    for(auto& instruct : basic_blocks[curr_block].instructions) {
-        if(instruct.larg == to_delete) instruct.larg = replacer;
-        if(instruct.rarg == to_delete) instruct.rarg = replacer;
+    // Find an if statement whose comparison only uses values from outside of the loop.
+    auto in_loop = [&](const instruct_t& instruct) {
+        for(bb_t b = loop_header; b <= last; ++b) {
+            for(const Instruction& instruction : basic_blocks[b].instructions) {
+                if(instruction.instruction_number == instruct) return true;
+            }
+        }
+        return false;
+    };
+    bb_t condition = -1;
+    const Instruction* cmp = nullptr;
+    for(bb_t b = loop_header + 1; b <= last && condition == -1; ++b) {
+        const Instruction& branch_instruction = basic_blocks[b].branch_instruction;
+        if(is_loop_header(b) || basic_blocks[b].successors.size() != 2 || !has_trait(branch_instruction.opcode, IS_BRANCH) ||
+           branch_instruction.opcode == Opcode::BRA || branch_instruction.opcode == Opcode::RET || branch_instruction.opcode == Opcode::END) continue;
+        for(const Instruction& instruction : basic_blocks[b].instructions) {
+            if(instruction.instruction_number != branch_instruction.larg) continue;
+            if(in_loop(instruction.larg) || in_loop(instruction.rarg)) break;
+            if(is_const_instruction(instruction.larg) && is_const_instruction(instruction.rarg)) break;
+            condition = b;
+            cmp = &instruction;
+        }
+    }
+    if(condition == -1) return -1;
+    const Opcode test = basic_blocks[condition].branch_instruction.opcode;
+    const instruct_t larg = cmp->larg;
+    const instruct_t rarg = cmp->rarg;
+
+    // The preheader branches to one of the loops, so neither loop can be entered straight from it (the header's
+    // phi functions are resolved on the way in). The loop gets a preheader of its own, right before its header,
+    // which moves the loop's blocks up by one.
+    enter_value_scope(preheader);
+    shift_blocks(loop_header, 1);
+    for(auto& [header, base] : loop_marker_bases) {
+        if(header >= loop_header) ++header;
+    }
+    const bb_t then_preheader = loop_header;
+    const bb_t header = loop_header + 1;
+    BasicBlock& then_entry = basic_blocks[then_preheader];
+    then_entry.identifier_values = basic_blocks[preheader].identifier_values;
+    then_entry.type = IF_FALLTHROUGH;
+    then_entry.predecessors = { preheader };
+    then_entry.successors = { header };
+    std::ranges::replace(basic_blocks[preheader].successors, header, then_preheader);
+    std::ranges::replace(basic_blocks[header].predecessors, preheader, then_preheader);
+    dom_tree.insert_blocks(loop_header, 1);
+    dom_tree.add_block(then_preheader, preheader);
+    dom_tree.set_idom(header, then_preheader);
+    const bb_t then_condition = condition + 1;
+    const bb_t then_last = last + 1;
+
+    // The loop exits into its own block, which branches to the join.
+    const bb_t then_exit = new_block(header, WHILE_BRANCH);
+    set_branch_location(header, first_instruction(then_exit));
+
+    // The preheader tests the condition, branching to the copy of the loop like it'd branch to the else branch.
+    const bb_t else_preheader = new_block(preheader, IF_BRANCH);
+    const std::unordered_map<instruct_t, instruct_t> copies = copy_blocks(header, then_last, else_preheader, basic_blocks.size());
+    const bb_t offset = else_preheader + 1 - header;
+    set_branch_cond(preheader, test, add_instruction(preheader, Opcode::CMP, larg, rarg));
+    set_branch_location(preheader, first_instruction(else_preheader));
+    const bb_t else_header = header + offset;
+    const bb_t else_exit = new_block(else_header, WHILE_BRANCH);
+    set_branch_location(else_header, first_instruction(else_exit));
+
+    // The loop only takes the then branch (falling through), and its copy only takes the else branch.
+    auto cut_edge = [&](const bb_t from, const bb_t to) {
+        std::erase(basic_blocks[from].successors, to);
+        std::erase(basic_blocks[to].predecessors, from);
+    };
+    const bb_t else_branch = *std::ranges::find_if(basic_blocks[then_condition].successors, [&](const bb_t& successor) {
+        return first_instruction(successor) == basic_blocks[then_condition].branch_instruction.rarg;
+    });
+    Instruction& then_branch_instruction = basic_blocks[then_condition].branch_instruction;
+    then_branch_instruction = Instruction(then_branch_instruction.instruction_number, Opcode::EMPTY, -1, -1);
+    cut_edge(then_condition, else_branch);
+    Instruction& else_branch_instruction = basic_blocks[then_condition + offset].branch_instruction;
+    else_branch_instruction = Instruction(else_branch_instruction.instruction_number, Opcode::BRA, else_branch_instruction.rarg, -1);
+    cut_edge(then_condition + offset, *std::ranges::find_if(basic_blocks[then_condition + offset].successors, [&](const bb_t& successor) {
+        return successor != else_branch + offset;
+    }));
+
+    const bb_t join = new_block(then_exit, else_exit, preheader);
+    set_branch_cond(then_exit, Opcode::BRA, first_instruction(join));
+    return join;
+}
+
+std::unordered_map<instruct_t, instruct_t> IntermediateRepresentation::copy_blocks(const bb_t& first, const bb_t& last, const bb_t& entry, const bb_t& position) {
+    reset_cfg_analyses();
+    const bool appended = position == static_cast<bb_t>(basic_blocks.size());
+    const bb_t offset = position - first;
+    auto copy_block = [&](const bb_t& b) {
+        return b >= first && b <= last ? b + offset : b;
+    };
+
+    // Every copied instruction gets a new number.
+    std::unordered_map<instruct_t, instruct_t> copies;
+    for(bb_t b = first; b <= last; ++b) {
+        for(const Instruction& instruction : basic_blocks[b].instructions) copies[instruction.instruction_number] = ++instruction_count;
+        const instruct_t branch_instruct = basic_blocks[b].branch_instruction.instruction_number;
+        if(branch_instruct != -1) copies[branch_instruct] = ++instruction_count;
     }
-    if(curr_block == branch_back) return;
-    for(const auto& successor : basic_blocks[curr_block].successors) {
-        cse_replace(successor, branch_back, replacer, to_delete);
+    auto copy = [&](const instruct_t& instruct) {
+        auto it = copies.find(instruct);
+        return it == copies.end() ? instruct : it->second;
+    };
+
+    for(bb_t b = first; b <= last; ++b) {
+        BasicBlock block(basic_blocks[b]);
+        block.index = copy_block(b);
+        for(bb_t& predecessor : block.predecessors) predecessor = b == first ? entry : copy_block(predecessor);
+        // Edges leaving the copied blocks are left for the caller to add.
+        std::erase_if(block.successors, [&](const bb_t& successor) { return successor < first || successor > last; });
+        for(bb_t& successor : block.successors) successor = copy_block(successor);
+        if(block.branch_block != -1) block.branch_block = copy_block(block.branch_block);
+        if(block.loop_header != -1) block.loop_header = copy_block(block.loop_header);
+        for(Instruction& instruction : block.instructions) {
+            if(instruction.opcode == Opcode::PHI && phi_owners.contains(instruction.instruction_number)) {
+                phi_owners[copies.at(instruction.instruction_number)] = phi_owners.at(instruction.instruction_number);
+            }
+            instruction.instruction_number = copies.at(instruction.instruction_number);
+            // Calls keep their callee.
+            if(instruction.opcode != Opcode::JSR) instruction.larg = copy(instruction.larg);
+            instruction.rarg = copy(instruction.rarg);
+        }
+        // Labels are instruction numbers too, so the branches are copied the same way.
+        block.branch_instruction.instruction_number = copy(block.branch_instruction.instruction_number);
+        block.branch_instruction.larg = copy(block.branch_instruction.larg);
+        block.branch_instruction.rarg = copy(block.branch_instruction.rarg);
+        for(ident_t ident = 0; ident < block.identifier_values.size(); ++ident) {
+            const instruct_t value = block.identifier_values.get(ident);
+            if(copies.contains(value)) block.change_instruction(ident, copies.at(value));
+        }
+        if(appended) {
+            basic_blocks.emplace_back(std::move(block));
+            dom_tree.add_block(copy_block(b), b == first ? entry : copy_block(dom_tree.get_idom(b)));
+        } else {
+            basic_blocks[copy_block(b)] = std::move(block);
+        }
     }
+    basic_blocks[entry].successors.emplace_back(first + offset);
+
+    // PHI affinity groups (like commit_while, an enclosing loop does this once it's done)
+    if(!while_loop) {
+        for(bb_t b = first + offset; b <= last + offset; ++b) {
+            for(const Instruction& instruction : basic_blocks[b].instructions) {
+                if(instruction.opcode == Opcode::PHI) establish_affinity_group(instruction.instruction_number, instruction.larg, instruction.rarg);
+            }
+        }
+    }
+    return copies;
+}
+
+void IntermediateRepresentation::shift_blocks(const bb_t& position, const ssize_t& count) {
+    reset_cfg_analyses();
+    auto shift = [&](bb_t& b) {
+        if(b >= position) b += count;
+    };
+    if(count < 0) basic_blocks.erase(basic_blocks.begin() + position + count, basic_blocks.begin() + position);
+    for(BasicBlock& block : basic_blocks) {
+        shift(block.index);
+        for(bb_t& predecessor : block.predecessors) shift(predecessor);
+        for(bb_t& successor : block.successors) shift(successor);
+        if(block.branch_block != -1) shift(block.branch_block);
+        if(block.loop_header != -1) shift(block.loop_header);
+    }
+    for(ssize_t i = 0; i < count; ++i) basic_blocks.emplace(basic_blocks.begin() + position + i, position + i);
+}
+
+InstructionList::iterator IntermediateRepresentation::remove_instruction(const bb_t& b, InstructionList::iterator it) {
+    InstructionList& instructions = basic_blocks[b].instructions;
+    if(it != instructions.begin()) return instructions.erase(it);
+    // The first instruction's number is the block's label, which branches may already refer to.
+    it->opcode = Opcode::EMPTY;
+    it->larg = -1;
+    it->rarg = -1;
+    return ++it;
+}
+
+bool IntermediateRepresentation::is_safe_to_hoist(const Instruction& instruction) const {
+    if(instruction.opcode != Opcode::DIV) return true;
+    return is_const_instruction(instruction.rarg) && get_const_value(instruction.rarg) != 0 && get_const_value(instruction.rarg) != -1;
 }
 
 void IntermediateRepresentation::update_phi(const bb_t& loop_header, const bb_t& branch_back) {
     if(ignore) return;
-    // if(will_return(branch_back)) return;
-    basic_blocks[loop_header].branch_block = branch_back;
-    basic_blocks[branch_back].loop_header = loop_header;
+    reset_cfg_analyses();
+    if(branch_back != -1) {
+        basic_blocks[loop_header].branch_block = branch_back;
+        basic_blocks[branch_back].loop_header = loop_header;
+    }
+    // Without a back edge, every identifier keeps the value it entered the header with.
+    const bool loops_back = branch_back != -1 && !will_return(branch_back);
+    const bb_t preheader = basic_blocks[loop_header].predecessors.front();
+    const IdentifierMap markers = basic_blocks[loop_header].identifier_values;
+    const IdentifierMap& back_values = loops_back ? basic_blocks[branch_back].identifier_values : markers;
 
-    const std::vector<instruct_t>& loop_ident_vals = basic_blocks[loop_header].identifier_values;
-    const std::vector<instruct_t>& branch_ident_vals = basic_blocks[branch_back].identifier_values;
-    std::vector<std::tuple<int, instruct_t, instruct_t>> changed_idents;
+    // Identifiers keep the value they entered the loop with, unless they have a phi function.
+    basic_blocks[loop_header].identifier_values = basic_blocks[preheader].identifier_values;
+    std::vector<ident_t> phi_idents;
 
+    // Complete the phi functions of identifiers that were read inside of the loop.
     for(Instruction& instruction : basic_blocks[loop_header].instructions) {
         if(instruction.opcode != Opcode::PHI) break;
-        if(loop_ident_vals[instruction.larg_owner] != branch_ident_vals[instruction.larg_owner] && !will_return(branch_back)) {
-            instruction.rarg = branch_ident_vals[instruction.larg_owner];
-            instruction.rarg_owner = instruction.larg_owner;
-            // establish_affinity_group(instruction.instruction_number, instruction.larg, instruction.rarg);
-        } else {
-            instruction.rarg = instruction.larg;
-            instruction.rarg_owner = instruction.larg_owner;
-            instruction.opcode = Opcode::DELETED;
-            changed_idents.emplace_back(instruction.larg_owner, instruction.larg, instruction.instruction_number);
+        const ident_t ident = phi_owners.at(instruction.instruction_number);
+        instruction.rarg = peek_value(back_values.get(ident));
+        change_ident_value(loop_header, ident, instruction.instruction_number);
+        phi_idents.emplace_back(ident);
+    }
+
+    // Create phi functions for identifiers that were only assigned inside of the loop. The branch back block's
+    // values are derived from the markers, so only the identifiers that were assigned are visited.
+    std::vector<std::pair<ident_t, instruct_t>> assigned;
+    markers.for_each_difference(back_values, [&](const ident_t& ident, const instruct_t& marker, const instruct_t& back) {
+        if(loop_phis.find(marker) == loop_phis.end()) assigned.emplace_back(ident, back);
+    });
+    for(const auto& [ident, back] : assigned) {
+        const instruct_t entry = resolve_value(basic_blocks[preheader].identifier_values.get(ident));
+        if(back == entry) {
+            change_ident_value(loop_header, ident, entry);
+            continue;
         }
+        const instruct_t phi_instruct = prepend_instruction(loop_header, Opcode::PHI, { entry, ident }, { -1, -1 });
+        Instruction& phi = basic_blocks[loop_header].instructions.front();
+        phi.rarg = back;
+        loop_phis[markers.get(ident)] = phi_instruct;
+        change_ident_value(loop_header, ident, phi_instruct);
+        phi_idents.emplace_back(ident);
     }
 
-    update_ident_vals(loop_header, changed_idents, true);
-    update_ident_vals_loop(basic_blocks[loop_header].successors[0], changed_idents); 
+    // Remove trivial phi functions (both arguments being the same value, or the phi function itself coming
+    // back around the loop). Removing one can make another trivial, so repeat until none are left.
+    std::unordered_map<instruct_t, instruct_t> replacements;
+    auto replacement = [&](instruct_t instruct) {
+        for(auto it = replacements.find(instruct); it != replacements.end(); it = replacements.find(instruct)) instruct = it->second;
+        return instruct;
+    };
+    for(bool removed = true; removed;) {
+        removed = false;
+        for(Instruction& instruction : basic_blocks[loop_header].instructions) {
+            if(instruction.opcode != Opcode::PHI) break;
+            if(replacements.find(instruction.instruction_number) != replacements.end()) continue;
+            instruction.larg = replacement(instruction.larg);
+            instruction.rarg = replacement(instruction.rarg);
+            if(instruction.rarg != instruction.larg && instruction.rarg != instruction.instruction_number) continue;
+            replacements[instruction.instruction_number] = instruction.larg;
+            removed = true;
+        }
+    }
+    if(replacements.empty()) return;
+
+    basic_blocks[loop_header].instructions.erase_if([&](const Instruction& instruction) {
+        return instruction.opcode == Opcode::PHI && replacements.find(instruction.instruction_number) != replacements.end();
+    });
+    for(auto& [old_instruct, new_instruct] : replacements) new_instruct = replacement(new_instruct);
+    for(const ident_t& ident : phi_idents) {
+        change_ident_value(loop_header, ident, replacement(basic_blocks[loop_header].get_ident_value(ident)));
+    }
+    for(auto& [marker, phi_instruct] : loop_phis) phi_instruct = replacement(phi_instruct);
+    // Blocks that return from inside of the loop aren't part of it, but can still use its phi functions.
+    replace_uses(loop_header, replacements);
+}
+
+void IntermediateRepresentation::replace_uses(const bb_t& first_block, const std::unordered_map<instruct_t, instruct_t>& replacements) {
+    // A replacement can itself have been replaced.
+    auto replacement = [&](instruct_t instruct) {
+        for(auto it = replacements.find(instruct); it != replacements.end(); it = replacements.find(instruct)) instruct = it->second;
+        return instruct;
+    };
+    for(bb_t b = first_block; b < static_cast<bb_t>(basic_blocks.size()); ++b) {
+        for(Instruction& instruction : basic_blocks[b].instructions) {
+            // A call's left argument is its callee's label, which isn't a use of the instruction it's numbered after.
+            const instruct_t larg = instruction.opcode == Opcode::JSR ? instruction.larg : replacement(instruction.larg);
+            set_arguments(b, instruction, larg, replacement(instruction.rarg));
+        }
+        Instruction& branch_instruction = basic_blocks[b].branch_instruction;
+        if(branch_instruction.opcode == Opcode::RET) branch_instruction.larg = replacement(branch_instruction.larg);
+    }
 }
 
-void IntermediateRepresentation::generate_phi(const bb_t& loop_header, const bb_t& branch_back) {
+instruct_t IntermediateRepresentation::loop_marker(const bb_t& loop_header, const ident_t& ident) const {
+    // Loop headers are created in index order, so their marker bases are sorted by header too.
+    auto it = std::ranges::lower_bound(loop_marker_bases, loop_header, {}, &std::pair<bb_t, instruct_t>::first);
+    return -2 - (it->second + ident);
+}
+
+bool IntermediateRepresentation::is_loop_marker(const instruct_t& instruct) const {
+    return instruct <= -2;
+}
+
+instruct_t IntermediateRepresentation::peek_value(const instruct_t& value) const {
+    if(!is_loop_marker(value)) return value;
+    auto phi = loop_phis.find(value);
+    return phi == loop_phis.end() ? value : phi->second;
+}
+
+instruct_t IntermediateRepresentation::resolve_value(const instruct_t& value) {
+    if(!is_loop_marker(value)) return value;
+    auto phi = loop_phis.find(value);
+    if(phi != loop_phis.end()) return phi->second;
+
+    // Find the loop header the marker belongs to.
+    const instruct_t index = -2 - value;
+    auto it = std::ranges::upper_bound(loop_marker_bases, index, {}, &std::pair<bb_t, instruct_t>::second) - 1;
+    const bb_t loop_header = it->first;
+    const ident_t ident = index - it->second;
+
+    // The value entering the loop may itself be a marker of an enclosing loop.
+    const instruct_t entry = resolve_value(basic_blocks[basic_blocks[loop_header].predecessors.front()].identifier_values.get(ident));
+    const instruct_t phi_instruct = prepend_instruction(loop_header, Opcode::PHI, { entry, ident }, { -1, -1 });
+    loop_phis[value] = phi_instruct;
+    return phi_instruct;
+}
+
+instruct_t IntermediateRepresentation::first_instruction(const bb_t& b) {
+    if(ignore) return -1;
+    if(basic_blocks[b].instructions.size() == 0) add_instruction(b, Opcode::EMPTY);
+    return basic_blocks[b].instructions.front().instruction_number;
+}
+
+instruct_t IntermediateRepresentation::get_ident_value(const bb_t& b, const ident_t& ident) {    
+    if(ignore) return -1;
+    return resolve_value(basic_blocks[b].get_ident_value(ident));
+}
+
+void IntermediateRepresentation::change_ident_value(const bb_t& b, const ident_t& ident, const instruct_t& instruct) {
     if(ignore) return;
-    if(will_return(branch_back)) return;
-    basic_blocks[loop_header].branch_block = branch_back;
-    basic_blocks[branch_back].loop_header = loop_header;
-    std::vector<instruct_t>& loop_ident_vals = basic_blocks[loop_header].identifier_values;
-    const std::vector<instruct_t>& branch_ident_vals = basic_blocks[branch_back].identifier_values;
-    std::vector<std::tuple<int, instruct_t, instruct_t>> changed_idents;
+    basic_blocks[b].change_instruction(ident, instruct);
+}
 
-    for(size_t i = 0; i < loop_ident_vals.size(); ++i) {
-        if(loop_ident_vals[i] != branch_ident_vals[i]) {
-            instruct_t old_ident_val = loop_ident_vals[i];
-            prepend_instruction(loop_header, Opcode::PHI, { loop_ident_vals[i], i }, { branch_ident_vals[i], i });
-            changed_idents.emplace_back(i, instruction_count, old_ident_val);
-        } 
+void IntermediateRepresentation::fix_func_call(const bb_t& b, const instruct_t& instruct, const instruct_t& larg) {
+    // Unswitching a loop moves the blocks after its preheader, so the call may have moved past the given block.
+    for(bb_t block = b; block < static_cast<bb_t>(basic_blocks.size()); ++block) {
+        for(Instruction& instruction : basic_blocks[block].instructions) {
+            if(instruction.instruction_number != instruct) continue;
+            instruction.larg = larg;
+            return;
+        }
     }
+}
 
-    update_ident_vals(loop_header, changed_idents, true);
-    update_ident_vals_loop(basic_blocks[loop_header].successors[0], changed_idents); 
+void IntermediateRepresentation::finish_construction() {
+    loop_phis.clear();
+    phi_owners.clear();
+    std::vector<std::pair<bb_t, instruct_t>>().swap(loop_marker_bases);
+    marker_count = 0;
 }
 
-void IntermediateRepresentation::update_ident_vals_loop(const bb_t& curr_block, const std::vector<std::tuple<int, instruct_t, instruct_t>>& changed_idents) {
-    if(ignore) return;
-    update_ident_vals(curr_block, changed_idents, false);
-    if(basic_blocks[curr_block].successors.size() == 0) return;
-    update_ident_vals_loop(basic_blocks[curr_block].successors[0], changed_idents);
-    if(basic_blocks[curr_block].successors.size() == 2) {
-        update_ident_vals_loop(basic_blocks[curr_block].successors[1], changed_idents);
+void IntermediateRepresentation::eliminate_dead_code() {
+    // Where every instruction is defined.
+    std::vector<const Instruction*> definitions(instruction_count + 1, nullptr);
+    for(const BasicBlock& block : basic_blocks) {
+        for(const Instruction& instruction : block.instructions) {
+            definitions[instruction.instruction_number] = &instruction;
+        }
     }
+
+    // Mark from the side effects.
+    std::vector<bool> live(instruction_count + 1, false);
+    std::vector<instruct_t> worklist;
+    auto mark = [&](const instruct_t& instruct) {
+        if(instruct < 0 || instruct > instruction_count || live[instruct]) return;
+        live[instruct] = true;
+        worklist.emplace_back(instruct);
+    };
+    auto mark_arguments = [&](const Instruction& instruction) {
+        if(has_trait(instruction.opcode, VALUE_OPERANDS) || instruction.opcode == Opcode::PHI) {
+            mark(instruction.larg);
+            mark(instruction.rarg);
+        } else if(has_trait(instruction.opcode, IS_BRANCH) && instruction.opcode != Opcode::BRA) {
+            // Conditional branches use the comparison in their left argument.
+            mark(instruction.larg);
+        }
+    };
+    for(const BasicBlock& block : basic_blocks) {
+        for(const Instruction& instruction : block.instructions) {
+            if(has_trait(instruction.opcode, HAS_SIDE_EFFECTS)) mark(instruction.instruction_number);
+        }
+        mark_arguments(block.branch_instruction);
+    }
+    while(!worklist.empty()) {
+        const instruct_t instruct = worklist.back();
+        worklist.pop_back();
+        if(definitions[instruct]) mark_arguments(*definitions[instruct]);
+    }
+
+    // Sweep everything unmarked. The const block is left alone since constants are never emitted.
+    std::vector<bool> dead(instruction_count + 1, false);
+    for(instruct_t instruct = 0; instruct <= instruction_count; ++instruct) dead[instruct] = !live[instruct];
+    remove_instructions(dead);
 }
-void IntermediateRepresentation::update_ident_vals_until(bb_t curr_block, bb_t stop_block, const std::vector<std::tuple<int, instruct_t, instruct_t>>& changed_idents) {
-    if(ignore) return;
-    while(curr_block != stop_block) {
-        bb_t idom = doms[curr_block];
-        update_ident_vals(curr_block, changed_idents, false);
-        if(basic_blocks[curr_block].predecessors.size() == 2) {
-            update_ident_vals_until(basic_blocks[curr_block].predecessors[0], idom, changed_idents);
-            update_ident_vals_until(basic_blocks[curr_block].predecessors[1], idom, changed_idents);
+
+void IntermediateRepresentation::eliminate_tail_calls() {
+    // Functions are done from the last one to the first, so the blocks of the ones left aren't moved.
+    bool eliminated = false;
+    for(ssize_t function = static_cast<ssize_t>(basic_blocks[0].successors.size()) - 2; function >= 0; --function) {
+        eliminated |= eliminate_tail_call(function);
+    }
+    if(eliminated) compute_dominators();
+}
+
+bool IntermediateRepresentation::eliminate_tail_call(const size_t& function) {
+    const bb_t first = basic_blocks[0].successors[function];
+    const bb_t last = basic_blocks[0].successors[function + 1] - 1;
+    const instruct_t label = basic_blocks[first].instructions.front().instruction_number;
+
+    // The function must return the value of a call to itself (made last in its block) from exactly
+    // one block, since a loop header can only have one back edge.
+    bb_t tail_block = -1;
+    for(bb_t b = first; b <= last; ++b) {
+        const BasicBlock& block = basic_blocks[b];
+        if(block.branch_instruction.opcode != Opcode::RET || block.instructions.empty()) continue;
+        const Instruction& call = block.instructions.back();
+        if(call.opcode != Opcode::JSR || call.larg != label || block.branch_instruction.larg != call.instruction_number) continue;
+        if(tail_block != -1) return false;
+        tail_block = b;
+    }
+    if(tail_block == -1 || tail_block == first || basic_blocks[tail_block].loop_header != -1) return false;
+    const instruct_t call = basic_blocks[tail_block].instructions.back().instruction_number;
+    const std::optional<std::vector<instruct_t>> setpars = call_arguments(tail_block, call);
+    if(!setpars) return false;
+
+    // Split the entry block after its parameters. The rest of it becomes the loop's header.
+    shift_blocks(first + 1, 1);
+    const bb_t loop_header = first + 1;
+    const bb_t branch_back = tail_block + 1;
+    BasicBlock& entry = basic_blocks[first];
+    BasicBlock& header = basic_blocks[loop_header];
+    auto body = std::ranges::find_if(entry.instructions, [](const Instruction& instruction) { return instruction.opcode != Opcode::GETPAR; });
+    for(auto instruction = body; instruction != entry.instructions.end();) {
+        header.instructions.push_back(*instruction);
+        instruction = entry.instructions.erase(instruction);
+    }
+    header.branch_instruction = entry.branch_instruction;
+    entry.branch_instruction = Instruction(-1, Opcode::EMPTY, -1, -1);
+    header.successors = std::move(entry.successors);
+    entry.successors = { loop_header };
+    header.predecessors = { first };
+    for(const bb_t& successor : header.successors) std::ranges::replace(basic_blocks[successor].predecessors, first, loop_header);
+    if(entry.instructions.empty()) {
+        // Without parameters the entry's label moved to the header, so calls need a new one.
+        const instruct_t entry_label = ++instruction_count;
+        entry.add_instruction(entry_label, Opcode::EMPTY, -1, -1);
+        for(BasicBlock& block : basic_blocks) {
+            for(Instruction& instruction : block.instructions) {
+                if(instruction.opcode == Opcode::JSR && instruction.larg == label) instruction.larg = entry_label;
+            }
         }
-        curr_block = idom;
     }
+    if(header.instructions.empty()) header.add_instruction(++instruction_count, Opcode::EMPTY, -1, -1);
+
+    // Every use of a parameter now uses its phi function, which gets the argument of the tail call
+    // around the back edge.
+    std::unordered_map<instruct_t, instruct_t> replacements;
+    std::vector<std::pair<instruct_t, instruct_t>> phis;
+    for(const Instruction& instruction : entry.instructions) {
+        if(instruction.opcode != Opcode::GETPAR) continue;
+        replacements[instruction.instruction_number] = ++instruction_count;
+        phis.emplace_back(instruction.instruction_number, instruction_count);
+    }
+    replace_uses(first, replacements);
+    BasicBlock& tail = basic_blocks[branch_back];
+    std::vector<bool> removed(instruction_count + 1, false);
+    auto setpar = setpars->begin();
+    for(const auto& [getpar, phi] : phis | std::views::reverse) {
+        // Parameters are popped in reverse, so the last parameter gets the first argument.
+        const instruct_t argument = std::ranges::find(tail.instructions, *setpar++, &Instruction::instruction_number)->larg;
+        header.prepend_instruction(phi, Opcode::PHI, getpar, argument);
+        establish_affinity_group(phi, getpar, argument);
+    }
+    for(const instruct_t& setpar : *setpars) removed[setpar] = true;
+    removed[call] = true;
+
+    header.branch_block = branch_back;
+    tail.loop_header = loop_header;
+    tail.branch_instruction = Instruction(tail.branch_instruction.instruction_number, Opcode::BRA, header.instructions.front().instruction_number, -1);
+    remove_instructions(removed);
+    return true;
 }
 
-void IntermediateRepresentation::update_ident_vals(const bb_t& b, const std::vector<std::tuple<int, instruct_t, instruct_t>>& changed_idents, const bool& skip_phi) {
-    if(ignore) return;
-    // changed_idents<0, 1, 2>:
-    // 0: index of identifier to change
-    // 1: new instruction number to change to
-    // 2: old instruction number to change from
-    for(const auto& triplet : changed_idents) {
-        // WARNING: THE FOLLOWING FOR LOOP WAS ADDED FOR PHI DESTRUCTION PROPAGATION
-        // It didn't exist for normal phi propagation
-        for(ident_t ident = 0; ident < static_cast<ident_t>(basic_blocks[b].identifier_values.size()); ++ident) {
-            if (basic_blocks[b].identifier_values[ident] == std::get<2>(triplet)) {
-                basic_blocks[b].identifier_values[ident] = std::get<1>(triplet);
+void IntermediateRepresentation::inline_calls() {
+    // Calls are inlined from the last one to the first, so the blocks of the ones left aren't moved.
+    std::vector<std::tuple<bb_t, instruct_t, size_t>> calls;
+    std::unordered_map<instruct_t, size_t> call_counts;
+    for(bb_t b = 1; b < static_cast<bb_t>(basic_blocks.size()); ++b) {
+        for(const Instruction& instruction : basic_blocks[b].instructions) {
+            if(instruction.opcode != Opcode::JSR) continue;
+            calls.emplace_back(b, instruction.instruction_number, get_loop_depth(b));
+            ++call_counts[instruction.larg];
+        }
+    }
+    bool inlined = false;
+    for(const auto& [b, call, depth] : calls | std::views::reverse) {
+        const instruct_t callee = std::ranges::find(basic_blocks[b].instructions, call, &Instruction::instruction_number)->larg;
+        const size_t budget = std::max(INLINE_BUDGET * (depth + 1), call_counts[callee] == 1 ? SINGLE_CALL_BUDGET : 0);
+        inlined |= inline_call(b, call, budget);
+    }
+    if(!inlined) return;
+    remove_uncalled_functions();
+    compute_dominators();
+}
+
+bool IntermediateRepresentation::inline_call(const bb_t& b, const instruct_t& call, const size_t& budget) {
+    if(is_loop_header(b)) return false;
+    const std::pmr::vector<bb_t>& functions = basic_blocks[0].successors;
+    auto it = std::ranges::find(basic_blocks[b].instructions, call, &Instruction::instruction_number);
+    const ssize_t function = find_function(it->larg);
+    if(function == -1) return false;
+    bb_t first = functions[function];
+    bb_t last = functions[function + 1] - 1;
+    if(b >= first && b <= last) return false;
+
+    // The callee must be small enough, not call itself, and return from at most two blocks, one of
+    // them being its last block (which falls through to where the call returns).
+    size_t size = 0;
+    const size_t params = parameter_count(first);
+    std::vector<bb_t> returns;
+    for(bb_t callee_block = first; callee_block <= last; ++callee_block) {
+        for(const Instruction& instruction : basic_blocks[callee_block].instructions) {
+            if(instruction.opcode == Opcode::JSR && instruction.larg == it->larg) return false;
+            else if(instruction.opcode != Opcode::EMPTY && instruction.opcode != Opcode::GETPAR) ++size;
+        }
+        if(basic_blocks[callee_block].branch_instruction.opcode == Opcode::RET) returns.emplace_back(callee_block);
+    }
+    if(size > budget || returns.empty() || returns.size() > 2 || returns.back() != last) return false;
+    auto returns_value = [&](const bb_t& return_block) { return basic_blocks[return_block].branch_instruction.larg != -1; };
+    if(!std::ranges::all_of(returns, returns_value)) {
+        if(returns.size() == 2) return false;
+        for(const BasicBlock& block : basic_blocks) {
+            for(const Instruction& instruction : block.instructions) {
+                if(instruction.larg == call || instruction.rarg == call) return false;
+            }
+            if(block.branch_instruction.opcode == Opcode::RET && block.branch_instruction.larg == call) return false;
+        }
+    }
+
+    const std::optional<std::vector<instruct_t>> setpars = call_arguments(b, call);
+    if(!setpars || setpars->size() != params) return false;
+
+    // Make room for the callee's blocks and the block the call returns to.
+    const size_t count = last - first + 1;
+    shift_blocks(b + 1, count + 1);
+    if(first > b) {
+        first += count + 1;
+        last += count + 1;
+        for(bb_t& return_block : returns) return_block += count + 1;
+    }
+    const bb_t tail = b + count + 1;
+
+    // Everything after the call moves to the block the call returns to.
+    BasicBlock& block = basic_blocks[b];
+    BasicBlock& tail_block = basic_blocks[tail];
+    it = std::ranges::find(block.instructions, call, &Instruction::instruction_number);
+    for(auto instruction = std::next(it); instruction != block.instructions.end();) {
+        tail_block.instructions.push_back(*instruction);
+        instruction = block.instructions.erase(instruction);
+    }
+    tail_block.branch_instruction = block.branch_instruction;
+    block.branch_instruction = Instruction(-1, Opcode::EMPTY, -1, -1);
+    tail_block.successors = std::move(block.successors);
+    block.successors.clear();
+    for(const bb_t& successor : tail_block.successors) std::ranges::replace(basic_blocks[successor].predecessors, b, tail);
+    if(block.loop_header != -1) {
+        tail_block.loop_header = block.loop_header;
+        basic_blocks[block.loop_header].branch_block = tail;
+        block.loop_header = -1;
+    }
+
+    // Copy the callee in between, with its parameters replaced by the arguments.
+    const std::unordered_map<instruct_t, instruct_t> copies = copy_blocks(first, last, b, b + 1);
+    const bb_t offset = b + 1 - first;
+    std::unordered_map<instruct_t, instruct_t> replacements;
+    std::vector<bool> removed(instruction_count + 1, false);
+    removed[call] = true;
+    size_t param = params;
+    for(const Instruction& instruction : basic_blocks[first].instructions) {
+        if(instruction.opcode != Opcode::GETPAR) continue;
+        // Parameters are popped in reverse.
+        const instruct_t setpar = (*setpars)[--param];
+        const instruct_t getpar = copies.at(instruction.instruction_number);
+        replacements[getpar] = std::ranges::find(block.instructions, setpar, &Instruction::instruction_number)->larg;
+        removed[getpar] = true;
+        removed[setpar] = true;
+    }
+
+    // The last block falls through to the block the call returns to, and the other return branches to it.
+    std::vector<instruct_t> values;
+    for(const bb_t& return_block : returns) {
+        BasicBlock& copy = basic_blocks[return_block + offset];
+        // A returned parameter is the argument it was replaced with.
+        const auto replaced = replacements.find(copy.branch_instruction.larg);
+        values.emplace_back(replaced == replacements.end() ? copy.branch_instruction.larg : replaced->second);
+        copy.successors.emplace_back(tail);
+        tail_block.predecessors.emplace_back(return_block + offset);
+    }
+    if(returns.size() == 2) {
+        const instruct_t phi = ++instruction_count;
+        tail_block.prepend_instruction(phi, Opcode::PHI, values.front(), values.back());
+        establish_affinity_group(phi, values.front(), values.back());
+        replacements[call] = phi;
+    } else if(values.front() != -1) {
+        replacements[call] = values.front();
+    }
+    tail_block.type = returns.size() == 2 ? JOIN : NONE;
+    for(const bb_t& return_block : returns) {
+        Instruction& branch_instruction = basic_blocks[return_block + offset].branch_instruction;
+        if(return_block == last) branch_instruction = Instruction(branch_instruction.instruction_number, Opcode::EMPTY, -1, -1);
+        else branch_instruction = Instruction(branch_instruction.instruction_number, Opcode::BRA, tail_block.instructions.front().instruction_number, -1);
+    }
+
+    replace_uses(1, replacements);
+    removed.resize(instruction_count + 1, false);
+    remove_instructions(removed);
+    return true;
+}
+
+std::optional<std::vector<instruct_t>> IntermediateRepresentation::call_arguments(const bb_t& b, const instruct_t& call) const {
+    // The call's arguments are the last parameters pushed before it (other calls pop theirs).
+    std::vector<instruct_t> pushed;
+    for(const Instruction& instruction : basic_blocks[b].instructions) {
+        if(instruction.instruction_number == call) break;
+        if(instruction.opcode == Opcode::SETPAR) {
+            pushed.emplace_back(instruction.instruction_number);
+        } else if(instruction.opcode == Opcode::JSR) {
+            const ssize_t function = find_function(instruction.larg);
+            if(function == -1) return std::nullopt;
+            const size_t popped = parameter_count(basic_blocks[0].successors[function]);
+            if(popped > pushed.size()) return std::nullopt;
+            pushed.resize(pushed.size() - popped);
+        }
+    }
+    const auto it = std::ranges::find(basic_blocks[b].instructions, call, &Instruction::instruction_number);
+    const ssize_t callee = find_function(it->larg);
+    if(callee == -1) return std::nullopt;
+    const size_t params = parameter_count(basic_blocks[0].successors[callee]);
+    if(params > pushed.size()) return std::nullopt;
+    return std::vector<instruct_t>(pushed.end() - params, pushed.end());
+}
+
+size_t IntermediateRepresentation::parameter_count(const bb_t& entry) const {
+    return std::ranges::count(basic_blocks[entry].instructions, Opcode::GETPAR, &Instruction::opcode);
+}
+
+void IntermediateRepresentation::remove_uncalled_functions() {
+    // Removing a function can leave the functions only it called uncalled too.
+    for(bool removed = true; removed;) {
+        removed = false;
+        std::unordered_set<instruct_t> called;
+        for(const BasicBlock& block : basic_blocks) {
+            for(const Instruction& instruction : block.instructions) {
+                if(instruction.opcode == Opcode::JSR) called.insert(instruction.larg);
             }
         }
-        // WARNING: THE FOLLOWING WAS COMMENTED OUT FOR PHI DESTRUCTION PROPAGATION
-        // It wasn't commented out for normal phi propagation
-        // basic_blocks[b].identifier_values[std::get<0>(triplet)] = std::get<1>(triplet);
-        for(auto& instruct : basic_blocks[b].instructions) {
-            if(skip_phi && instruct.opcode == PHI) continue;
-            // WARNING: COMMENTING OUT THE CURRENT COMMENTED OUT PORTION IS DANGEROUS IF WE DO NORMAL PHI PROPAGATION
-            // However, phi DESTRUCTION propagation is fine because ownership of a phi doesn't matter. We want ALL
-            // references of that phi number to be replaced. 
-            if(instruct.larg == std::get<2>(triplet) /* && instruct.larg_owner == std::get<0>(triplet) */) instruct.larg = std::get<1>(triplet); 
-            if(instruct.rarg == std::get<2>(triplet) /* && instruct.rarg_owner == std::get<0>(triplet) */) instruct.rarg = std::get<1>(triplet);
+        // The last functions go first, so the blocks of the ones left aren't moved.
+        for(ssize_t function = basic_blocks[0].successors.size() - 2; function >= 0; --function) {
+            const bb_t first = basic_blocks[0].successors[function];
+            const bb_t last = basic_blocks[0].successors[function + 1] - 1;
+            if(called.contains(basic_blocks[first].instructions.front().instruction_number)) continue;
+            std::erase(basic_blocks[0].successors, first);
+            shift_blocks(last + 1, first - last - 1);
+            removed = true;
         }
     }
 }
 
-instruct_t IntermediateRepresentation::first_instruction(const bb_t& b) {
-    if(ignore) return -1;
-    if(basic_blocks[b].instructions.size() == 0) add_instruction(b, Opcode::EMPTY);
-    return basic_blocks[b].instructions.front().instruction_number;
+ssize_t IntermediateRepresentation::find_function(const instruct_t& label) const {
+    // The last entry is the main function, which can't be called.
+    const std::pmr::vector<bb_t>& functions = basic_blocks[0].successors;
+    for(size_t function = 0; function + 1 < functions.size(); ++function) {
+        if(!basic_blocks[functions[function]].instructions.empty() && basic_blocks[functions[function]].instructions.front().instruction_number == label) {
+            return function;
+        }
+    }
+    return -1;
 }
 
-instruct_t IntermediateRepresentation::get_ident_value(const bb_t& b, const ident_t& ident) {    
-    if(ignore) return -1;
-    return basic_blocks[b].get_ident_value(ident);
+void IntermediateRepresentation::eliminate_redundant_calls() {
+    const std::unordered_set<instruct_t> pure = find_pure_functions();
+    if(pure.empty()) return;
+    hoist_calls(find_speculatable_functions(pure));
+
+    // A call to a pure function is redundant if a call with the same arguments dominates it.
+    std::vector<std::pair<bb_t, std::vector<instruct_t>>> calls; // The callee's label, the arguments, then the call.
+    std::unordered_map<instruct_t, instruct_t> replacements;
+    std::vector<bool> removed(instruction_count + 1, false);
+    auto replacement = [&](instruct_t instruct) {
+        for(auto it = replacements.find(instruct); it != replacements.end(); it = replacements.find(instruct)) instruct = it->second;
+        return instruct;
+    };
+    for(bb_t b = 1; b < static_cast<bb_t>(basic_blocks.size()); ++b) {
+        std::unordered_map<instruct_t, instruct_t> arguments;
+        for(const Instruction& instruction : basic_blocks[b].instructions) {
+            if(instruction.opcode == Opcode::SETPAR) arguments[instruction.instruction_number] = replacement(instruction.larg);
+            if(instruction.opcode != Opcode::JSR || !pure.contains(instruction.larg)) continue;
+            const std::optional<std::vector<instruct_t>> setpars = call_arguments(b, instruction.instruction_number);
+            if(!setpars) continue;
+            std::vector<instruct_t> key{ instruction.larg };
+            for(const instruct_t& setpar : *setpars) key.emplace_back(arguments.at(setpar));
+            auto earlier = std::ranges::find_if(calls, [&](const std::pair<bb_t, std::vector<instruct_t>>& call) {
+                return std::equal(key.begin(), key.end(), call.second.begin(), call.second.end() - 1) && dominates(call.first, b);
+            });
+            if(earlier == calls.end()) {
+                key.emplace_back(instruction.instruction_number);
+                calls.emplace_back(b, std::move(key));
+                continue;
+            }
+            replacements[instruction.instruction_number] = earlier->second.back();
+            removed[instruction.instruction_number] = true;
+            for(const instruct_t& setpar : *setpars) removed[setpar] = true;
+        }
+    }
+    if(replacements.empty()) return;
+    replace_uses(1, replacements);
+    remove_instructions(removed);
+}
+
+void IntermediateRepresentation::hoist_calls(const std::unordered_set<instruct_t>& speculatable) {
+    if(speculatable.empty()) return;
+    // Nested loops are done first, so the calls they hoist can be hoisted again by the loops containing them.
+    const LoopForest& forest = get_loop_forest();
+    for(loop_t l = forest.get_loops().size() - 1; l >= 0; --l) {
+        const Loop& loop = forest.get(l);
+        if(loop.preheader == -1 || has_branch_instruction(loop.preheader)) continue;
+        std::unordered_set<instruct_t> variants;
+        for(const bb_t& b : loop.blocks) {
+            for(const Instruction& instruction : basic_blocks[b].instructions) variants.insert(instruction.instruction_number);
+        }
+
+        // A hoisted call's copy in the preheader makes the calls using its value loop-invariant too.
+        std::unordered_map<instruct_t, instruct_t> replacements;
+        std::vector<bool> removed(instruction_count + 1, false);
+        for(const bb_t& b : loop.blocks) {
+            for(const Instruction& instruction : basic_blocks[b].instructions) {
+                if(instruction.opcode != Opcode::JSR || !speculatable.contains(instruction.larg)) continue;
+                const std::optional<std::vector<instruct_t>> setpars = call_arguments(b, instruction.instruction_number);
+                if(!setpars) continue;
+                std::vector<instruct_t> arguments;
+                for(const instruct_t& setpar : *setpars) {
+                    const instruct_t argument = std::ranges::find(basic_blocks[b].instructions, setpar, &Instruction::instruction_number)->larg;
+                    auto it = replacements.find(argument);
+                    arguments.emplace_back(it == replacements.end() ? argument : it->second);
+                }
+                if(std::ranges::any_of(arguments, [&](const instruct_t& argument) { return variants.contains(argument); })) continue;
+                BasicBlock& preheader = basic_blocks[loop.preheader];
+                for(const instruct_t& argument : arguments) preheader.add_instruction(++instruction_count, Opcode::SETPAR, argument, -1);
+                preheader.add_instruction(++instruction_count, Opcode::JSR, instruction.larg, -1);
+                replacements[instruction.instruction_number] = instruction_count;
+                removed[instruction.instruction_number] = true;
+                for(const instruct_t& setpar : *setpars) removed[setpar] = true;
+            }
+        }
+        if(replacements.empty()) continue;
+        replace_uses(1, replacements);
+        removed.resize(instruction_count + 1, false);
+        remove_instructions(removed);
+    }
 }
 
-void IntermediateRepresentation::change_ident_value(const bb_t& b, const ident_t& ident, const instruct_t& instruct) {
-    if(ignore) return;
-    basic_blocks[b].change_instruction(ident, instruct);
+std::unordered_set<instruct_t> IntermediateRepresentation::find_pure_functions() const {
+    // Every function without I/O starts out pure, and stops being pure if it calls one that isn't.
+    const std::pmr::vector<bb_t>& functions = basic_blocks[0].successors;
+    std::unordered_map<instruct_t, std::vector<instruct_t>> callees;
+    for(size_t function = 0; function + 1 < functions.size(); ++function) {
+        std::vector<instruct_t>& called = callees[basic_blocks[functions[function]].instructions.front().instruction_number];
+        for(bb_t b = functions[function]; b < functions[function + 1]; ++b) {
+            for(const Instruction& instruction : basic_blocks[b].instructions) {
+                if(instruction.opcode == Opcode::READ || instruction.opcode == Opcode::WRITE || instruction.opcode == Opcode::WRITENL) called.emplace_back(-1);
+                else if(instruction.opcode == Opcode::JSR) called.emplace_back(instruction.larg);
+            }
+        }
+    }
+    std::unordered_set<instruct_t> pure;
+    for(const auto& [label, called] : callees) pure.insert(label);
+    for(bool changed = true; changed;) {
+        changed = false;
+        for(const auto& [label, called] : callees) {
+            if(!pure.contains(label) || std::ranges::all_of(called, [&](const instruct_t& callee) { return pure.contains(callee); })) continue;
+            pure.erase(label);
+            changed = true;
+        }
+    }
+    return pure;
+}
+
+std::unordered_set<instruct_t> IntermediateRepresentation::find_speculatable_functions(const std::unordered_set<instruct_t>& pure) const {
+    // A pure function without loops or divisions that could trap always returns. Functions only calling
+    // such functions do too, which leaves out recursion.
+    const std::pmr::vector<bb_t>& functions = basic_blocks[0].successors;
+    std::unordered_set<instruct_t> speculatable;
+    for(bool changed = true; changed;) {
+        changed = false;
+        for(size_t function = 0; function + 1 < functions.size(); ++function) {
+            const instruct_t label = basic_blocks[functions[function]].instructions.front().instruction_number;
+            if(!pure.contains(label) || speculatable.contains(label)) continue;
+            bool returns = true;
+            for(bb_t b = functions[function]; b < functions[function + 1] && returns; ++b) {
+                if(is_loop_header(b)) returns = false;
+                for(const Instruction& instruction : basic_blocks[b].instructions) {
+                    if(!is_safe_to_hoist(instruction) || (instruction.opcode == Opcode::JSR && !speculatable.contains(instruction.larg))) returns = false;
+                }
+            }
+            if(!returns) continue;
+            speculatable.insert(label);
+            changed = true;
+        }
+    }
+    return speculatable;
+}
+
+void IntermediateRepresentation::propagate_constants() {
+    const ConstantPropagation constants(basic_blocks, const_instructions, instruction_count);
+
+    // Instructions with a constant value are replaced by the constant, and phi functions with
+    // only one incoming edge that can be taken are replaced by that edge's argument.
+    std::vector<bool> removed(instruction_count + 1, false);
+    std::unordered_map<instruct_t, instruct_t> replacements;
+    for(bb_t b = 1; b < static_cast<bb_t>(basic_blocks.size()); ++b) {
+        BasicBlock& block = basic_blocks[b];
+        if(!constants.is_executable(b)) {
+            // Nothing in a block that can't run is needed.
+            for(const Instruction& instruction : block.instructions) removed[instruction.instruction_number] = true;
+            block.branch_instruction.opcode = Opcode::EMPTY;
+            block.branch_instruction.larg = -1;
+            block.branch_instruction.rarg = -1;
+            continue;
+        }
+        for(const Instruction& instruction : block.instructions) {
+            const LatticeValue& value = constants.get(instruction.instruction_number);
+            if(value.state == LatticeValue::CONSTANT && has_trait(instruction.opcode, HAS_RESULT)) {
+                replacements[instruction.instruction_number] = add_instruction(0, Opcode::CONST, value.value);
+                removed[instruction.instruction_number] = true;
+            } else if(instruction.opcode == Opcode::PHI) {
+                const auto [left, right] = constants.get_phi_predecessors(b);
+                const bool left_executable = constants.is_executable(left, b);
+                const bool right_executable = right != -1 && constants.is_executable(right, b);
+                if(left_executable == right_executable) continue;
+                replacements[instruction.instruction_number] = left_executable ? instruction.larg : instruction.rarg;
+                removed[instruction.instruction_number] = true;
+            }
+        }
+
+        // Conditional branches that always go the same way become a jump or a fallthrough.
+        Instruction& branch_instruction = block.branch_instruction;
+        if(!has_trait(branch_instruction.opcode, IS_BRANCH) || branch_instruction.opcode == Opcode::BRA ||
+           branch_instruction.opcode == Opcode::RET || branch_instruction.opcode == Opcode::END) continue;
+        const bb_t target = constants.get_branch_target(b);
+        const bool taken = constants.is_executable(b, target);
+        const bool falls_through = std::ranges::any_of(block.successors, [&](const bb_t& successor) {
+            return successor != target && constants.is_executable(b, successor);
+        });
+        if(taken && !falls_through) {
+            branch_instruction.opcode = Opcode::BRA;
+            branch_instruction.larg = branch_instruction.rarg;
+            branch_instruction.rarg = -1;
+        } else if(!taken && falls_through) {
+            branch_instruction.opcode = Opcode::EMPTY;
+            branch_instruction.larg = -1;
+            branch_instruction.rarg = -1;
+        }
+    }
+    if(!replacements.empty()) replace_uses(1, replacements);
+    remove_instructions(removed);
+
+    // Edges that can't be taken are removed from the CFG, leaving the blocks that can't run
+    // unreachable. Loops whose back edge can't be taken no longer loop.
+    for(BasicBlock& block : basic_blocks) {
+        std::erase_if(block.successors, [&](const bb_t& successor) { return !constants.is_executable(block.index, successor); });
+        std::erase_if(block.predecessors, [&](const bb_t& predecessor) { return !constants.is_executable(predecessor, block.index); });
+        if(block.branch_block != -1 && !constants.is_executable(block.branch_block, block.index)) {
+            basic_blocks[block.branch_block].loop_header = -1;
+            block.branch_block = -1;
+        }
+    }
+    reset_cfg_analyses();
+    compute_dominators();
+}
+
+void IntermediateRepresentation::specialize_functions() {
+    // Specialized copies go after the other functions, so the ones left aren't moved.
+    bool specialized = false;
+    const size_t functions = basic_blocks[0].successors.size() - 1;
+    for(size_t function = 0; function < functions; ++function) specialized |= specialize_function(function);
+    if(!specialized) return;
+    remove_uncalled_functions();
+    compute_dominators();
+    propagate_constants();
+}
+
+bool IntermediateRepresentation::specialize_function(const size_t& function) {
+    const bb_t first = basic_blocks[0].successors[function];
+    const bb_t last = basic_blocks[0].successors[function + 1] - 1;
+    const instruct_t label = basic_blocks[first].instructions.front().instruction_number;
+    std::vector<instruct_t> params;
+    for(const Instruction& instruction : basic_blocks[first].instructions) {
+        // Parameters are popped in reverse.
+        if(instruction.opcode == Opcode::GETPAR) params.insert(params.begin(), instruction.instruction_number);
+    }
+    if(params.empty()) return false;
+
+    // Every call's arguments must be known.
+    auto arguments = [&](const bb_t& b, const instruct_t& call) -> std::optional<std::vector<instruct_t>> {
+        const std::optional<std::vector<instruct_t>> setpars = call_arguments(b, call);
+        if(!setpars) return std::nullopt;
+        std::vector<instruct_t> values;
+        for(const instruct_t& setpar : *setpars) values.emplace_back(std::ranges::find(basic_blocks[b].instructions, setpar, &Instruction::instruction_number)->larg);
+        return values;
+    };
+    std::vector<std::pair<instruct_t, std::vector<instruct_t>>> calls; // The call, then its arguments.
+    std::vector<bool> recursive;
+    for(bb_t b = 1; b < static_cast<bb_t>(basic_blocks.size()); ++b) {
+        for(const Instruction& instruction : basic_blocks[b].instructions) {
+            if(instruction.opcode != Opcode::JSR || instruction.larg != label) continue;
+            std::optional<std::vector<instruct_t>> values = arguments(b, instruction.instruction_number);
+            if(!values) return false;
+            calls.emplace_back(instruction.instruction_number, std::move(*values));
+            recursive.emplace_back(b >= first && b <= last);
+        }
+    }
+    if(calls.empty()) return false;
+
+    // A parameter every call passes the same constant to (or passes on unchanged) is that constant.
+    std::unordered_map<instruct_t, instruct_t> bindings;
+    for(size_t param = 0; param < params.size(); ++param) {
+        instruct_t constant = -1;
+        for(size_t call = 0; call < calls.size(); ++call) {
+            const instruct_t& value = calls[call].second[param];
+            if(recursive[call] && value == params[param]) continue;
+            // Constants are common subexpressions of the const block, so equal ones are the same instruction.
+            if(!const_instructions.contains(value) || (constant != -1 && value != constant)) {
+                constant = -1;
+                break;
+            }
+            constant = value;
+        }
+        if(constant != -1) bindings[params[param]] = constant;
+    }
+    if(!bindings.empty()) replace_uses(first, bindings);
+
+    // Calls passing constants to the other parameters are grouped by those constants. Parameters
+    // only used by phi functions (like those of eliminated tail calls) would fold nothing.
+    size_t size = 0;
+    std::unordered_set<instruct_t> foldable;
+    for(bb_t b = first; b <= last; ++b) {
+        for(const Instruction& instruction : basic_blocks[b].instructions) {
+            if(instruction.opcode == Opcode::EMPTY || instruction.opcode == Opcode::GETPAR) continue;
+            ++size;
+            if(instruction.opcode == Opcode::PHI || instruction.opcode == Opcode::JSR) continue;
+            foldable.insert(instruction.larg);
+            foldable.insert(instruction.rarg);
+        }
+    }
+    std::vector<std::pair<std::vector<instruct_t>, std::unordered_set<instruct_t>>> specializations; // The constants (or -1), then the calls.
+    for(size_t call = 0; call < calls.size() && size <= SPECIALIZE_BUDGET; ++call) {
+        if(recursive[call]) continue;
+        std::vector<instruct_t> constants;
+        for(size_t param = 0; param < params.size(); ++param) {
+            const instruct_t& value = calls[call].second[param];
+            const bool bound = bindings.contains(params[param]) || !foldable.contains(params[param]);
+            constants.emplace_back(const_instructions.contains(value) && !bound ? value : -1);
+        }
+        if(std::ranges::all_of(constants, [](const instruct_t& constant) { return constant == -1; })) continue;
+        auto specialization = std::ranges::find(specializations, constants, &std::pair<std::vector<instruct_t>, std::unordered_set<instruct_t>>::first);
+        if(specialization != specializations.end()) specialization->second.insert(calls[call].first);
+        else if(specializations.size() < SPECIALIZATIONS) specializations.emplace_back(std::move(constants), std::unordered_set<instruct_t>{ calls[call].first });
+    }
+
+    // Each specialized copy goes right before the main function.
+    for(const auto& [constants, specialized_calls] : specializations) {
+        const bb_t position = basic_blocks[0].successors.back();
+        shift_blocks(position, last - first + 1);
+        const std::unordered_map<instruct_t, instruct_t> copies = copy_blocks(first, last, 0, position);
+        std::pmr::vector<bb_t>& functions = basic_blocks[0].successors;
+        std::iter_swap(functions.end() - 2, functions.end() - 1);
+        const instruct_t copy_label = copies.at(label);
+        std::unordered_map<instruct_t, instruct_t> replacements;
+        for(size_t param = 0; param < params.size(); ++param) {
+            if(constants[param] != -1) replacements[copies.at(params[param])] = constants[param];
+        }
+        replace_uses(position, replacements);
+
+        // The copy's recursive calls passing the same constants call the copy too.
+        std::unordered_set<instruct_t> retargeted = specialized_calls;
+        for(bb_t b = position; b <= position + last - first; ++b) {
+            for(const Instruction& instruction : basic_blocks[b].instructions) {
+                if(instruction.opcode != Opcode::JSR || instruction.larg != label) continue;
+                const std::optional<std::vector<instruct_t>> values = arguments(b, instruction.instruction_number);
+                bool same = values.has_value();
+                for(size_t param = 0; same && param < params.size(); ++param) same = constants[param] == -1 || (*values)[param] == constants[param];
+                if(same) retargeted.insert(instruction.instruction_number);
+            }
+        }
+        for(BasicBlock& block : basic_blocks) {
+            for(Instruction& instruction : block.instructions) {
+                if(instruction.opcode == Opcode::JSR && retargeted.contains(instruction.instruction_number)) instruction.larg = copy_label;
+            }
+        }
+    }
+    return !bindings.empty() || !specializations.empty();
+}
+
+void IntermediateRepresentation::unroll_loops() {
+    bool unrolled = false;
+    const LoopForest& forest = get_loop_forest();
+    for(const Loop& loop : forest.get_loops()) {
+        // The loop's body is a single block that branches back to the header.
+        const bb_t& body = loop.branch_back;
+        if(!loop.children.empty() || loop.blocks.size() != 2 || body != loop.header + 1) continue;
+        const InductionVariables variables(basic_blocks, const_instructions, loop);
+        const ssize_t trips = constant_trip_count(loop, variables);
+        if(trips <= 0) continue;
+
+        const size_t size = std::ranges::count_if(basic_blocks[body].instructions, [](const Instruction& instruction) {
+            return instruction.opcode != Opcode::EMPTY;
+        });
+        // A call costs far more than the loop's control, so loops making them are left alone.
+        if(std::ranges::any_of(basic_blocks[body].instructions, [](const Instruction& instruction) { return instruction.opcode == Opcode::JSR; })) continue;
+        const bool has_preheader = loop.preheader != -1 && !has_branch_instruction(loop.preheader);
+        size_t factor = 1;
+        if(static_cast<size_t>(trips) <= FULL_UNROLL_TRIPS && trips * size <= UNROLL_BUDGET) {
+            factor = trips;
+        } else {
+            for(size_t candidate = FULL_UNROLL_TRIPS; candidate > 1 && factor == 1; candidate /= 2) {
+                if(candidate * size <= UNROLL_BUDGET && candidate <= static_cast<size_t>(trips)) factor = candidate;
+            }
+        }
+        const size_t remainder = trips % factor;
+        if(factor == 1 || ((factor == static_cast<size_t>(trips) || remainder != 0) && !has_preheader)) continue;
+
+        // Iterations that don't fill a whole unrolled body (or all of them, when fully unrolling)
+        // run before the loop, so the loop starts from their values.
+        const size_t peeled = factor == static_cast<size_t>(trips) ? trips : remainder;
+        std::unordered_map<instruct_t, instruct_t> values;
+        for(const Instruction& phi : basic_blocks[loop.header].instructions) {
+            if(phi.opcode == Opcode::PHI) values[phi.instruction_number] = phi.larg;
+        }
+        if(peeled != 0) values = copy_iterations(loop.preheader, loop, values, peeled);
+        for(Instruction& phi : basic_blocks[loop.header].instructions) {
+            if(phi.opcode == Opcode::PHI) phi.larg = values.at(phi.instruction_number);
+        }
+
+        // The body itself is the first of the iterations it runs.
+        if(factor != static_cast<size_t>(trips)) {
+            for(const Instruction& phi : basic_blocks[loop.header].instructions) {
+                if(phi.opcode == Opcode::PHI) values[phi.instruction_number] = phi.rarg;
+            }
+            values = copy_iterations(body, loop, values, factor - 1);
+            for(Instruction& phi : basic_blocks[loop.header].instructions) {
+                if(phi.opcode == Opcode::PHI) phi.rarg = values.at(phi.instruction_number);
+            }
+        }
+        unrolled = true;
+    }
+    if(unrolled) propagate_constants();
+}
+
+ssize_t IntermediateRepresentation::constant_trip_count(const Loop& loop, const InductionVariables& variables) const {
+    // The header only tests a basic induction variable against a constant.
+    const Instruction& branch_instruction = basic_blocks[loop.header].branch_instruction;
+    if(!has_trait(branch_instruction.opcode, IS_BRANCH) || branch_instruction.opcode == Opcode::BRA ||
+       branch_instruction.opcode == Opcode::RET || branch_instruction.opcode == Opcode::END) return -1;
+    const Instruction* cmp = nullptr;
+    for(const Instruction& instruction : basic_blocks[loop.header].instructions) {
+        if(instruction.opcode == Opcode::PHI) continue;
+        if(instruction.opcode != Opcode::CMP || instruction.instruction_number != branch_instruction.larg) return -1;
+        cmp = &instruction;
+    }
+    if(!cmp) return -1;
+    const InductionVariable* counter = nullptr;
+    for(const InductionVariable& variable : variables.get_basic()) {
+        if(variable.phi == cmp->larg || variable.phi == cmp->rarg) counter = &variable;
+    }
+    if(!counter || !is_const_instruction(counter->init)) return -1;
+    for(const instruct_t& arg : { cmp->larg, cmp->rarg }) {
+        if(arg != counter->phi && !is_const_instruction(arg)) return -1;
+    }
+
+    // Run the loop's test until it fails.
+    long long value = get_const_value(counter->init);
+    auto argument = [&](const instruct_t& arg) {
+        return arg == counter->phi ? static_cast<int>(value) : get_const_value(arg);
+    };
+    for(ssize_t trips = 0; trips <= MAX_TRIP_COUNT; ++trips) {
+        if(ConstantPropagation::is_taken(branch_instruction.opcode, argument(cmp->larg), argument(cmp->rarg))) return trips;
+        value += counter->step;
+        if(value < INT_MIN || value > INT_MAX) return -1;
+    }
+    return -1;
+}
+
+std::unordered_map<instruct_t, instruct_t> IntermediateRepresentation::copy_iterations(const bb_t& b, const Loop& loop, std::unordered_map<instruct_t, instruct_t> values, const size_t& count) {
+    // The expressions the block computes, for the copies to reuse.
+    std::unordered_map<ValueKey, instruct_t, ValueKeyHash> expressions;
+    for(const Instruction& instruction : basic_blocks[b].instructions) {
+        if(has_trait(instruction.opcode, IS_CSE)) expressions.try_emplace(ValueKey(instruction.opcode, instruction.larg, instruction.rarg), instruction.instruction_number);
+    }
+
+    // The body is copied from a snapshot, since it may be the block the copies are appended to.
+    const std::vector<Instruction> body(basic_blocks[loop.branch_back].instructions.begin(), basic_blocks[loop.branch_back].instructions.end());
+    std::unordered_map<instruct_t, instruct_t> back_values;
+    for(const Instruction& phi : basic_blocks[loop.header].instructions) {
+        if(phi.opcode == Opcode::PHI) back_values[phi.instruction_number] = phi.rarg;
+    }
+    for(size_t iteration = 0; iteration < count; ++iteration) {
+        // Maps the header's phi functions and the body's instructions to their copies.
+        std::unordered_map<instruct_t, instruct_t> copies = values;
+        auto copy = [&](const instruct_t& instruct) {
+            auto it = copies.find(instruct);
+            return it == copies.end() ? instruct : it->second;
+        };
+        for(const Instruction& instruction : body) {
+            if(instruction.opcode == Opcode::EMPTY) continue;
+            Instruction copied(instruction.instruction_number, instruction.opcode, instruction.larg, instruction.rarg);
+            if(has_trait(instruction.opcode, VALUE_OPERANDS)) {
+                copied.larg = copy(instruction.larg);
+                copied.rarg = copy(instruction.rarg);
+            }
+            if(has_trait(copied.opcode, IS_CSE)) {
+                if(is_const_instruction(copied.larg) && is_const_instruction(copied.rarg)) {
+                    const LatticeValue folded = ConstantPropagation::fold(copied.opcode, get_const_value(copied.larg), get_const_value(copied.rarg));
+                    if(folded.state == LatticeValue::CONSTANT) {
+                        copies[instruction.instruction_number] = add_instruction(0, Opcode::CONST, folded.value);
+                        continue;
+                    }
+                }
+                auto it = expressions.find(ValueKey(copied.opcode, copied.larg, copied.rarg));
+                if(it != expressions.end()) {
+                    copies[instruction.instruction_number] = it->second;
+                    continue;
+                }
+            }
+            copied.instruction_number = ++instruction_count;
+            basic_blocks[b].instructions.push_back(copied);
+            copies[instruction.instruction_number] = copied.instruction_number;
+            if(has_trait(copied.opcode, IS_CSE)) expressions.try_emplace(ValueKey(copied.opcode, copied.larg, copied.rarg), copied.instruction_number);
+        }
+
+        // Every phi function takes its value coming around the back edge at once.
+        for(auto& [phi, value] : values) value = copy(back_values.at(phi));
+    }
+    return values;
+}
+
+void IntermediateRepresentation::reduce_strength() {
+    const LoopForest& forest = get_loop_forest();
+    for(loop_t l = forest.get_loops().size() - 1; l >= 0; --l) reduce_strength(forest.get(l));
+}
+
+void IntermediateRepresentation::reduce_strength(const Loop& loop) {
+    const InductionVariables variables(basic_blocks, const_instructions, loop);
+    if(variables.get_derived().empty()) return;
+
+    // Starting values and strides that aren't constants are computed in the preheader.
+    const bb_t preheader = loop.preheader != -1 && !has_branch_instruction(loop.preheader) ? loop.preheader : -1;
+    InstructionList& header = basic_blocks[loop.header].instructions;
+
+    std::unordered_map<instruct_t, instruct_t> replacements;
+    // A multiple by a positive constant for every basic induction variable, which it can be compared through.
+    std::map<size_t, std::tuple<int, instruct_t, instruct_t>> multiples;
+    for(const DerivedInductionVariable& derived : variables.get_derived()) {
+        const InductionVariable& basic = variables.get_basic()[derived.basic];
+        const instruct_t start = multiply(preheader, basic.init, derived.factor);
+        const instruct_t stride = multiply(preheader, add_instruction(0, Opcode::CONST, basic.step), derived.factor);
+        if(start == -1 || stride == -1) continue;
+
+        // The new phi function goes after the header's other phi functions, and its increment
+        // right after the basic induction variable's increment.
+        const instruct_t phi = ++instruction_count;
+        const instruct_t next = ++instruction_count;
+        auto phis_end = header.begin();
+        while(phis_end != header.end() && phis_end->opcode == Opcode::PHI) ++phis_end;
+        header.insert(phis_end, Instruction(phi, Opcode::PHI, start, next));
+        InstructionList& instructions = basic_blocks[basic.increment_block].instructions;
+        auto increment = instructions.begin();
+        while(increment->instruction_number != basic.increment) ++increment;
+        instructions.insert(std::next(increment), Instruction(next, Opcode::ADD, phi, stride));
+        establish_affinity_group(phi, start, next);
+
+        for(const instruct_t& product : derived.phi_products) replacements[product] = phi;
+        for(const instruct_t& product : derived.increment_products) replacements[product] = next;
+        if(is_const_instruction(derived.factor) && get_const_value(derived.factor) > 0) {
+            multiples.try_emplace(derived.basic, get_const_value(derived.factor), phi, next);
+        }
+    }
+    if(replacements.empty()) return;
+    replace_uses(1, replacements);
+
+    for(const auto& [basic, multiple] : multiples) {
+        const auto& [factor, phi, next] = multiple;
+        replace_test(loop, variables, variables.get_basic()[basic], factor, phi, next, replacements);
+    }
 }
 
-void IntermediateRepresentation::fix_func_call(const bb_t& b, const int& index, const instruct_t& larg) {
-    basic_blocks[b].instructions[index].larg = larg;
+void IntermediateRepresentation::replace_test(const Loop& loop, const InductionVariables& variables, const InductionVariable& variable, const int& factor,
+                                              const instruct_t& phi, const instruct_t& next, const std::unordered_map<instruct_t, instruct_t>& replacements) {
+    auto is_variable = [&](const instruct_t& instruct) {
+        return instruct == variable.phi || instruct == variable.increment;
+    };
+
+    // Besides each other and the replaced multiplies, the variable and its increment may only be compared.
+    std::vector<std::pair<bb_t, Instruction*>> tests;
+    for(bb_t b = 1; b < static_cast<bb_t>(basic_blocks.size()); ++b) {
+        for(Instruction& instruction : basic_blocks[b].instructions) {
+            if(!has_trait(instruction.opcode, VALUE_OPERANDS) && instruction.opcode != Opcode::PHI) continue;
+            if(!is_variable(instruction.larg) && !is_variable(instruction.rarg)) continue;
+            if(is_variable(instruction.instruction_number) || replacements.contains(instruction.instruction_number)) continue;
+            if(instruction.opcode != Opcode::CMP) return;
+            tests.emplace_back(b, &instruction);
+        }
+        const Instruction& branch_instruction = basic_blocks[b].branch_instruction;
+        if(branch_instruction.opcode == Opcode::RET && is_variable(branch_instruction.larg)) return;
+    }
+    if(tests.empty()) return;
+
+    // Multiplying both sides by a positive factor keeps the comparison's result. The other side
+    // is scaled in the preheader unless it's a constant, so it must be known before the loop.
+    const bb_t preheader = loop.preheader != -1 && !has_branch_instruction(loop.preheader) ? loop.preheader : -1;
+    const instruct_t scale = add_instruction(0, Opcode::CONST, factor);
+    std::vector<std::pair<instruct_t, instruct_t>> arguments;
+    for(const auto& [b, test] : tests) {
+        auto scaled = [&](const instruct_t& instruct) -> instruct_t {
+            if(instruct == variable.phi) return phi;
+            if(instruct == variable.increment) return next;
+            if(is_const_instruction(instruct)) return multiply(preheader, instruct, scale);
+            if(!variables.is_invariant(instruct) || !std::ranges::binary_search(loop.blocks, b)) return -1;
+            return multiply(preheader, instruct, scale);
+        };
+        arguments.emplace_back(scaled(test->larg), scaled(test->rarg));
+        if(arguments.back().first == -1 || arguments.back().second == -1) return;
+    }
+    for(size_t i = 0; i < tests.size(); ++i) {
+        tests[i].second->larg = arguments[i].first;
+        tests[i].second->rarg = arguments[i].second;
+    }
+}
+
+void IntermediateRepresentation::evaluate_closed_forms() {
+    const LoopForest& forest = get_loop_forest();
+    for(const Loop& loop : forest.get_loops()) {
+        const ScalarEvolution evolution(basic_blocks, const_instructions, loop);
+        if(evolution.is_computable()) evaluate_closed_forms(loop, evolution);
+    }
+}
+
+void IntermediateRepresentation::evaluate_closed_forms(const Loop& loop, const ScalarEvolution& evolution) {
+    const bb_t& b = loop.branch_back;
+    auto emit = [&](Opcode op, const instruct_t& larg, const instruct_t& rarg) {
+        basic_blocks[b].add_instruction(++instruction_count, op, larg, rarg);
+        return instruction_count;
+    };
+    auto constant = [&](const int& value) {
+        return add_instruction(0, Opcode::CONST, value);
+    };
+    const std::vector<InductionVariable>& variables = evolution.get_induction_variables().get_basic();
+    const TripCount& trip_count = evolution.get_trip_count();
+    const InductionVariable& counter = variables[trip_count.variable];
+    if(counter.step == INT_MIN) return;
+
+    // The iterations left, counting this one: the distance to the bound over the step, rounded up
+    // (or rounded down plus one when the bound can be reached).
+    const int step = std::abs(counter.step);
+    const instruct_t distance = counter.step > 0 ? emit(Opcode::SUB, trip_count.bound, counter.phi) : emit(Opcode::SUB, counter.phi, trip_count.bound);
+    instruct_t trips = distance;
+    if(trip_count.inclusive) {
+        if(step != 1) trips = emit(Opcode::DIV, distance, constant(step));
+        trips = emit(Opcode::ADD, trips, constant(1));
+    } else if(step != 1) {
+        trips = emit(Opcode::DIV, emit(Opcode::ADD, distance, constant(step - 1)), constant(step));
+    }
+
+    for(const Recurrence& recurrence : evolution.get_recurrences()) {
+        instruct_t total;
+        if(recurrence.variable == -1) {
+            total = multiply(b, trips, recurrence.addend);
+        } else {
+            // The sum of an induction variable over the iterations left is trips * variable plus
+            // step times the sum of 0 up to trips - 1 (or up to trips, once it's incremented).
+            const InductionVariable& variable = variables[recurrence.variable];
+            const instruct_t neighbour = emit(recurrence.incremented ? Opcode::ADD : Opcode::SUB, trips, constant(1));
+            const instruct_t triangle = emit(Opcode::DIV, emit(Opcode::MUL, trips, neighbour), constant(2));
+            const instruct_t start = multiply(b, trips, variable.phi);
+            total = emit(Opcode::ADD, start, multiply(b, triangle, constant(variable.step)));
+        }
+        const instruct_t last = emit(recurrence.negated ? Opcode::SUB : Opcode::ADD, recurrence.phi, total);
+        for(Instruction& phi : basic_blocks[loop.header].instructions) {
+            if(phi.instruction_number != recurrence.phi) continue;
+            phi.rarg = last;
+            establish_affinity_group(phi.instruction_number, phi.larg, last);
+            break;
+        }
+    }
+}
+
+instruct_t IntermediateRepresentation::multiply(const bb_t& b, const instruct_t& larg, const instruct_t& rarg) {
+    if(is_const_instruction(larg) && is_const_instruction(rarg)) {
+        const long long product = static_cast<long long>(get_const_value(larg)) * get_const_value(rarg);
+        if(product >= INT_MIN && product <= INT_MAX) return add_instruction(0, Opcode::CONST, static_cast<int>(product));
+    }
+    for(const auto& [factor, other] : { std::pair{ larg, rarg }, std::pair{ rarg, larg } }) {
+        if(!is_const_instruction(factor)) continue;
+        if(get_const_value(factor) == 0) return factor;
+        if(get_const_value(factor) == 1) return other;
+    }
+    if(b == -1) return -1;
+    // The value table isn't kept up to date once parsing is done, so the multiply isn't looked up in it.
+    basic_blocks[b].add_instruction(++instruction_count, Opcode::MUL, larg, rarg);
+    return instruction_count;
+}
+
+void IntermediateRepresentation::evaluate_partially() {
+    if(evaluate_main()) {
+        propagate_constants();
+        remove_uncalled_functions();
+        compute_dominators();
+    }
+    if(evaluate_calls()) {
+        propagate_constants();
+        remove_uncalled_functions();
+        compute_dominators();
+    }
+}
+
+bool IntermediateRepresentation::evaluate_main() {
+    compute_dominators();
+    const bb_t entry = basic_blocks[0].successors.back();
+    const bb_t exit = basic_blocks.size() - 1;
+    // Blocks outside of loops that every run goes through run exactly once, so the program can resume at any of them.
+    std::vector<bool> checkpoints(basic_blocks.size(), false);
+    for(bb_t b = entry + 1; b <= exit; ++b) checkpoints[b] = get_loop_depth(b) == 0 && dominates(b, exit);
+    Interpreter interpreter(basic_blocks, const_instructions, instruction_count, EVALUATION_FUEL);
+    const bool finished = interpreter.run(entry, checkpoints, EVALUATION_OUTPUT);
+    const std::optional<Checkpoint>& checkpoint = interpreter.get_checkpoint();
+    if(!finished && !checkpoint) return false;
+    const std::string output = interpreter.get_output().substr(0, finished ? std::string::npos : checkpoint->output_size);
+    // Every block before the one the program resumes at has been run for the last time.
+    const bb_t resume = finished ? exit + 1 : checkpoint->block;
+
+    // The rest of the program uses the values computed so far as constants, which they must fit in.
+    std::unordered_map<instruct_t, instruct_t> replacements;
+    for(bb_t b = resume; b <= exit; ++b) {
+        for(const Instruction& instruction : basic_blocks[b].instructions) {
+            if(instruction.opcode == Opcode::JSR) continue;
+            for(const instruct_t& argument : { instruction.larg, instruction.rarg }) {
+                auto value = checkpoint->values.find(argument);
+                if(value == checkpoint->values.end()) continue;
+                if(value->second < INT_MIN || value->second > INT_MAX) return false;
+                replacements[argument] = -1;
+            }
+        }
+        const Instruction& branch_instruction = basic_blocks[b].branch_instruction;
+        if(branch_instruction.opcode == Opcode::RET && checkpoint->values.contains(branch_instruction.larg)) {
+            const long long& value = checkpoint->values.at(branch_instruction.larg);
+            if(value < INT_MIN || value > INT_MAX) return false;
+            replacements[branch_instruction.larg] = -1;
+        }
+    }
+    for(auto& [instruct, constant] : replacements) constant = add_instruction(0, Opcode::CONST, static_cast<int>(checkpoint->values.at(instruct)));
+    replace_uses(entry, replacements);
+
+    // The entry block is kept to write the output, then falls through to where the program resumes,
+    // whose phi functions have already been run.
+    std::vector<bool> removed(instruction_count + 1, false);
+    for(bb_t b = entry; b < resume; ++b) {
+        for(const Instruction& instruction : basic_blocks[b].instructions) removed[instruction.instruction_number] = true;
+    }
+    if(!finished) {
+        for(const Instruction& instruction : basic_blocks[resume].instructions) {
+            if(instruction.opcode == Opcode::PHI) removed[instruction.instruction_number] = true;
+        }
+    }
+    remove_instructions(removed);
+    shift_blocks(resume, entry + 1 - resume);
+    BasicBlock& block = basic_blocks[entry];
+    if(!output.empty()) {
+        if(block.instructions.empty()) block.add_instruction(++instruction_count, Opcode::EMPTY, -1, -1);
+        Instruction& write = block.instructions.front();
+        write.opcode = Opcode::WRITESTR;
+        outputs[write.instruction_number] = output;
+    }
+    block.branch_instruction = Instruction(-1, Opcode::EMPTY, -1, -1);
+    block.type = NONE;
+    block.branch_block = -1;
+    block.loop_header = -1;
+    block.successors.clear();
+    if(!finished) {
+        block.successors = { entry + 1 };
+        basic_blocks[entry + 1].predecessors = { entry };
+        basic_blocks[entry + 1].type = NONE;
+    }
+    return true;
+}
+
+bool IntermediateRepresentation::evaluate_calls() {
+    const std::unordered_set<instruct_t> pure = find_pure_functions();
+    if(pure.empty()) return false;
+    Interpreter interpreter(basic_blocks, const_instructions, instruction_count, EVALUATION_FUEL);
+    std::unordered_map<instruct_t, instruct_t> replacements;
+    std::vector<bool> removed(instruction_count + 1, false);
+    for(bb_t b = 1; b < static_cast<bb_t>(basic_blocks.size()); ++b) {
+        for(const Instruction& instruction : basic_blocks[b].instructions) {
+            if(instruction.opcode != Opcode::JSR || !pure.contains(instruction.larg)) continue;
+            const std::optional<std::vector<instruct_t>> setpars = call_arguments(b, instruction.instruction_number);
+            if(!setpars) continue;
+            std::vector<long long> arguments;
+            for(const instruct_t& setpar : *setpars) {
+                const instruct_t argument = std::ranges::find(basic_blocks[b].instructions, setpar, &Instruction::instruction_number)->larg;
+                if(!is_const_instruction(argument)) break;
+                arguments.emplace_back(get_const_value(argument));
+            }
+            if(arguments.size() != setpars->size()) continue;
+            const std::optional<long long> result = interpreter.call(instruction.larg, arguments);
+            if(!result || *result < INT_MIN || *result > INT_MAX) continue;
+            replacements[instruction.instruction_number] = add_instruction(0, Opcode::CONST, static_cast<int>(*result));
+            removed[instruction.instruction_number] = true;
+            for(const instruct_t& setpar : *setpars) removed[setpar] = true;
+        }
+    }
+    if(replacements.empty()) return false;
+    replace_uses(1, replacements);
+    removed.resize(instruction_count + 1, false);
+    remove_instructions(removed);
+    return true;
+}
+
+void IntermediateRepresentation::remove_instructions(const std::vector<bool>& removed) {
+    std::unordered_map<instruct_t, instruct_t> labels;
+    auto& preference_list = allocation_analyses->preference_list;
+    for(bb_t b = 1; b < static_cast<bb_t>(basic_blocks.size()); ++b) {
+        InstructionList& instructions = basic_blocks[b].instructions;
+        for(auto it = instructions.begin(); it != instructions.end();) {
+            if(!removed[it->instruction_number] || it->opcode == Opcode::EMPTY) {
+                ++it;
+                continue;
+            }
+            auto pref = preference_list.find(it->instruction_number);
+            if(pref != preference_list.end()) {
+                for(const instruct_t& affinity : pref->second.affinities) {
+                    preference_list.at(affinity).affinities.erase(it->instruction_number);
+                }
+                preference_list.erase(pref);
+            }
+            if(it == instructions.begin() && std::next(it) != instructions.end()) {
+                labels[it->instruction_number] = std::next(it)->instruction_number;
+                it = instructions.erase(it);
+            } else {
+                it = remove_instruction(b, it);
+            }
+        }
+    }
+    if(labels.empty()) return;
+
+    // A label can move more than once if several leading instructions were removed.
+    auto relabel = [&](instruct_t& label) {
+        for(auto it = labels.find(label); it != labels.end(); it = labels.find(label)) label = it->second;
+    };
+    auto relabel_target = [&](Instruction& instruction) {
+        if(instruction.opcode == Opcode::BRA || instruction.opcode == Opcode::JSR) relabel(instruction.larg);
+        else if(has_trait(instruction.opcode, IS_BRANCH) && instruction.opcode != Opcode::RET) relabel(instruction.rarg);
+    };
+    for(BasicBlock& block : basic_blocks) {
+        for(Instruction& instruction : block.instructions) relabel_target(instruction);
+        relabel_target(block.branch_instruction);
+    }
+}
+
+void IntermediateRepresentation::memoize_functions() {
+    const std::unordered_set<instruct_t> pure = find_pure_functions();
+    const std::pmr::vector<bb_t>& functions = basic_blocks[0].successors;
+    for(size_t function = 0; function + 1 < functions.size(); ++function) {
+        const instruct_t label = basic_blocks[functions[function]].instructions.front().instruction_number;
+        const size_t params = parameter_count(functions[function]);
+        if(!pure.contains(label) || params == 0 || params > 2) continue;
+        bool recursive = false;
+        bool returns_values = true;
+        for(bb_t b = functions[function]; b < functions[function + 1]; ++b) {
+            recursive |= std::ranges::any_of(basic_blocks[b].instructions, [&](const Instruction& instruction) {
+                return instruction.opcode == Opcode::JSR && instruction.larg == label;
+            });
+            const Instruction& branch_instruction = basic_blocks[b].branch_instruction;
+            if(branch_instruction.opcode == Opcode::RET && branch_instruction.larg == -1) returns_values = false;
+        }
+        if(recursive && returns_values) memoized_functions.insert(label);
+    }
+}
+
+void IntermediateRepresentation::release_allocation_analyses() {
+    allocation_analyses.reset();
 }
 
 void IntermediateRepresentation::insert_live_in(const bb_t& b, const instruct_t& instruct) {
-    live_ins.at(b).insert(instruct);
+    allocation_analyses->live_ins.at(b).insert(instruct);
 }
 
 void IntermediateRepresentation::establish_affinity_group(const instruct_t& i1, const instruct_t& i2, const instruct_t& i3) {
+    auto& preference_list = allocation_analyses->preference_list;
     if(preference_list.find(i1) == preference_list.end() && !is_const_instruction(i1)) preference_list.insert( { i1, Preference(spill_count) } );
     if(preference_list.find(i2) == preference_list.end() && !is_const_instruction(i2)) preference_list.insert( { i2, Preference(spill_count) } );    
     if(preference_list.find(i3) == preference_list.end() && !is_const_instruction(i3)) preference_list.insert( { i3, Preference(spill_count) } ); 
@@ -452,11 +1884,21 @@ void IntermediateRepresentation::establish_affinity_group(const instruct_t& i1,
 }
 
 const std::vector<std::pair<Register, int>>& IntermediateRepresentation::get_instruction_preference(const instruct_t& instruct) {
+    auto& preference_list = allocation_analyses->preference_list;
     if(preference_list.find(instruct) == preference_list.end()) preference_list.insert( { instruct, Preference(spill_count) } );
     return preference_list.at(instruct).preference;
 }
 
+const std::pmr::unordered_set<instruct_t>& IntermediateRepresentation::get_memoized_functions() const {
+    return memoized_functions;
+}
+
+const std::string& IntermediateRepresentation::get_output(const instruct_t& instruct) const {
+    return outputs.at(instruct);
+}
+
 Preference& IntermediateRepresentation::get_preference(const instruct_t& instruct) {
+    auto& preference_list = allocation_analyses->preference_list;
     if(preference_list.find(instruct) != preference_list.end()) {
         return preference_list.at(instruct);
     } else {
@@ -465,7 +1907,7 @@ Preference& IntermediateRepresentation::get_preference(const instruct_t& instruc
     }
 }
 void IntermediateRepresentation::erase_live_in(const bb_t& b, const instruct_t& instruct) {
-    live_ins.at(b).erase(instruct);
+    allocation_analyses->live_ins.at(b).erase(instruct);
 }
 
 void IntermediateRepresentation::insert_death_point(const instruct_t& instruct, const instruct_t& death_point) {
@@ -473,6 +1915,7 @@ void IntermediateRepresentation::insert_death_point(const instruct_t& instruct,
 }
 
 bool IntermediateRepresentation::propagate_live_ins(const bb_t& b) {
+    auto& live_ins = allocation_analyses->live_ins;
     // Ensure everything (the block's successors) before the block has been analyzed first.
     for(const auto& successor : basic_blocks[b].successors) {
         if(!is_analyzed(successor)) return false;
@@ -489,41 +1932,70 @@ const Blocktype& IntermediateRepresentation::get_block_type(const bb_t& b) const
     return basic_blocks[b].type;
 }
 
-const std::vector<BasicBlock>& IntermediateRepresentation::get_basic_blocks() const {
+const std::pmr::vector<BasicBlock>& IntermediateRepresentation::get_basic_blocks() const {
     return basic_blocks;
 }
 
 const bb_t& IntermediateRepresentation::get_idom(const bb_t& b) const {
-    return doms.at(b);
+    return dom_tree.get_idom(b);
 }
 
-const std::vector<instruct_t>& IntermediateRepresentation::get_predecessors(const bb_t& b) const {
+const DominatorTree& IntermediateRepresentation::get_dominator_tree() const {
+    return dom_tree;
+}
+
+const std::vector<bb_t>& IntermediateRepresentation::get_dominance_frontier(const bb_t& b) {
+    if(!dominance_frontiers) dominance_frontiers = dom_tree.dominance_frontiers(basic_blocks);
+    return dominance_frontiers->at(b);
+}
+
+const LoopForest& IntermediateRepresentation::get_loop_forest() {
+    if(!loop_forest) loop_forest.emplace(basic_blocks);
+    return *loop_forest;
+}
+
+const CFGSnapshot& IntermediateRepresentation::get_cfg() {
+    if(!cfg_snapshot) cfg_snapshot.emplace(basic_blocks);
+    return *cfg_snapshot;
+}
+
+size_t IntermediateRepresentation::get_loop_depth(const bb_t& b) {
+    return get_loop_forest().get_loop_depth(b);
+}
+
+void IntermediateRepresentation::reset_cfg_analyses() {
+    loop_forest.reset();
+    cfg_snapshot.reset();
+    dominance_frontiers.reset();
+}
+
+const std::pmr::vector<bb_t>& IntermediateRepresentation::get_predecessors(const bb_t& b) const {
     return basic_blocks.at(b).predecessors;
 }
 
-const std::vector<instruct_t>& IntermediateRepresentation::get_successors(const bb_t& b) const {
+const std::pmr::vector<bb_t>& IntermediateRepresentation::get_successors(const bb_t& b) const {
     return basic_blocks.at(b).successors;
 }
 
-const std::vector<Instruction>& IntermediateRepresentation::get_instructions(const bb_t& b) const {
+const InstructionList& IntermediateRepresentation::get_instructions(const bb_t& b) const {
     return basic_blocks.at(b).instructions;
 }
 
-const instruct_t& IntermediateRepresentation::get_loop_header(const bb_t& b) const {
+const bb_t& IntermediateRepresentation::get_loop_header(const bb_t& b) const {
     if(basic_blocks.at(b).loop_header == -1) throw std::runtime_error("Given block does not have a loop header!");
     return basic_blocks.at(b).loop_header;
 }
 
-const instruct_t& IntermediateRepresentation::get_branch_back(const bb_t& b) const {
+const bb_t& IntermediateRepresentation::get_branch_back(const bb_t& b) const {
     if(basic_blocks.at(b).branch_block == -1) throw std::runtime_error("Given block does not have a branch block!");
     return basic_blocks.at(b).branch_block;
 }
 
-std::unordered_set<instruct_t>& IntermediateRepresentation::get_live_ins(const bb_t& b) {
-    return live_ins.at(b);
+std::pmr::unordered_set<instruct_t>& IntermediateRepresentation::get_live_ins(const bb_t& b) {
+    return allocation_analyses->live_ins.at(b);
 }
 
-std::unordered_map<instruct_t, std::unordered_set<instruct_t>>& IntermediateRepresentation::get_death_points() {
+std::pmr::unordered_map<instruct_t, std::pmr::unordered_set<instruct_t>>& IntermediateRepresentation::get_death_points() {
     return death_points;
 }
 
@@ -544,6 +2016,7 @@ const int& IntermediateRepresentation::get_const_value(const instruct_t& instruc
 }
 
 bool IntermediateRepresentation::is_live_instruction(const bb_t& b, const instruct_t& instruct) const {
+    const auto& live_ins = allocation_analyses->live_ins;
     return live_ins.at(b).find(instruct) != live_ins.at(b).end();
 }
 bool IntermediateRepresentation::is_const_instruction(const instruct_t& instruct) const {
@@ -586,7 +2059,7 @@ bool IntermediateRepresentation::has_assigned_register(const instruct_t& instruc
 }
 
 bool IntermediateRepresentation::has_preference(const instruct_t& instruct) const {
-    return preference_list.find(instruct) != preference_list.end();
+    return allocation_analyses->preference_list.find(instruct) != allocation_analyses->preference_list.end();
 }
 
 bool IntermediateRepresentation::has_death_point(const instruct_t& instruct, const instruct_t& death_point) const {
@@ -651,6 +2124,10 @@ bool IntermediateRepresentation::is_emitted(const bb_t& b) const {
     return basic_blocks.at(b).emitted;
 }
 
+bool IntermediateRepresentation::is_memoized(const instruct_t& label) const {
+    return memoized_functions.contains(label);
+}
+
 bool IntermediateRepresentation::is_const_block(const bb_t& b) const {
     return b == 0;
 }
@@ -683,8 +2160,8 @@ std::string IntermediateRepresentation::to_dotlang() const {
             msg += ";\n";
         }       
     }
-    for(size_t i = 1; i < doms.size(); ++i) {
-        msg += std::format("bb{}:b -> bb{}:b [color=blue, style=dotted, label=\"dom\"]\n", doms[i], i);
+    for(size_t i = 1; i < dom_tree.size(); ++i) {
+        msg += std::format("bb{}:b -> bb{}:b [color=blue, style=dotted, label=\"dom\"]\n", dom_tree.get_idom(i), i);
     }
     msg += "}\n";
     return msg;
@@ -716,9 +2193,10 @@ void IntermediateRepresentation::print_const_instructions() const {
 
 void IntermediateRepresentation::print_live_ins() const {
     std::cout << "--- Live-Ins ---" << std::endl;
+    if(!allocation_analyses) return;
     for(size_t block_index = 0; block_index < basic_blocks.size(); ++block_index) {
         std::cout << std::format("Block {}: ", block_index);
-        for(const auto& live : live_ins[block_index]) {
+        for(const auto& live : allocation_analyses->live_ins[block_index]) {
             std::cout << live << ", ";
         }
         std::cout << std::endl;
@@ -781,7 +2259,8 @@ void IntermediateRepresentation::print_death_points() const {
 
 void IntermediateRepresentation::print_affinity_groups() const {
     std::cout << "--- Affinity Groups ---" << std::endl;
-    for(const auto& pref : preference_list) {
+    if(!allocation_analyses) return;
+    for(const auto& pref : allocation_analyses->preference_list) {
         std::cout << "Instruction: " << pref.first << ", Affinities: ";
         for(const auto& affinity : pref.second.affinities) {
             std::cout << affinity << ", ";
@@ -792,7 +2271,8 @@ void IntermediateRepresentation::print_affinity_groups() const {
 
 void IntermediateRepresentation::print_preferences() const {
     std::cout << "--- Instruction Preferences ---" << std::endl;
-    for(const auto& pref : preference_list) {
+    if(!allocation_analyses) return;
+    for(const auto& pref : allocation_analyses->preference_list) {
         std::cout << "Instruction: " << pref.first << ", Preferences: ";
         auto copy = pref.second.preference;
         sort(copy.begin(), copy.end(), Preference::sort_by_preference);
@@ -812,7 +2292,7 @@ void IntermediateRepresentation::print_preferences() const {
 
 void IntermediateRepresentation::increase_spill_count() {    
     ++spill_count;
-    for(auto& pair : preference_list) {
+    for(auto& pair : allocation_analyses->preference_list) {
         for(int i = pair.second.preference.size(); i <= Register::UNASSIGNED + spill_count; ++i) {
             pair.second.preference.emplace_back(static_cast<Register>(i), pair.second.default_preference);            
         }
@@ -843,7 +2323,7 @@ void IntermediateRepresentation::constrain(const instruct_t& instruct, const bb_
         for(const auto& affinity : pref.affinities) {
             constrain(affinity, b, reg, false);
         }
-        for(const auto& conflict : live_ins.at(b)) {
+        for(const auto& conflict : allocation_analyses->live_ins.at(b)) {
             if(conflict == instruct) continue;
             dislike(conflict, b, reg, false);
         }
@@ -0,0 +1,189 @@
+#include "interpreter.hpp"
+#include <climits>
+
+Interpreter::Interpreter(const std::pmr::vector<BasicBlock>& basic_blocks, const std::pmr::unordered_map<instruct_t, int>& const_instructions, const instruct_t& instruction_count, const size_t& fuel)
+    : basic_blocks(basic_blocks), const_instructions(const_instructions), definitions(instruction_count + 1, nullptr), fuel(fuel) {
+    for(const BasicBlock& block : basic_blocks) {
+        if(!block.instructions.empty()) labels[block.instructions.front().instruction_number] = block.index;
+        for(const Instruction& instruction : block.instructions) definitions[instruction.instruction_number] = &instruction;
+    }
+}
+
+std::optional<long long> Interpreter::call(const instruct_t& label, const std::vector<long long>& arguments) {
+    auto entry = labels.find(label);
+    if(entry == labels.end()) return std::nullopt;
+    writes = false;
+    checkpoints = nullptr;
+    parameters = arguments;
+    const std::optional<long long> result = execute(entry->second);
+    if(!parameters.empty()) return std::nullopt;
+    return result;
+}
+
+bool Interpreter::run(const bb_t& entry, const std::vector<bool>& checkpoints, const size_t& output_budget) {
+    writes = true;
+    this->checkpoints = &checkpoints;
+    this->output_budget = output_budget;
+    parameters.clear();
+    output.clear();
+    checkpoint.reset();
+    return execute(entry).has_value();
+}
+
+const std::string& Interpreter::get_output() const {
+    return output;
+}
+
+const std::optional<Checkpoint>& Interpreter::get_checkpoint() const {
+    return checkpoint;
+}
+
+std::optional<long long> Interpreter::execute(const bb_t& entry) {
+    if(depth == MAX_DEPTH) return std::nullopt;
+    ++depth;
+    std::unordered_map<instruct_t, long long> values;
+    // The emitted code wraps around on overflow, so the arithmetic is done unsigned.
+    auto wrap = [](const unsigned long long& result) { return static_cast<long long>(result); };
+    auto run_instruction = [&](const Instruction& instruction) {
+        const std::optional<long long> larg = instruction.larg == -1 ? 0 : value(values, instruction.larg);
+        const std::optional<long long> rarg = instruction.rarg == -1 ? 0 : value(values, instruction.rarg);
+        switch(instruction.opcode) {
+            case Opcode::ADD:
+                if(!larg || !rarg) return false;
+                values[instruction.instruction_number] = wrap(static_cast<unsigned long long>(*larg) + static_cast<unsigned long long>(*rarg));
+                return true;
+            case Opcode::SUB:
+                if(!larg || !rarg) return false;
+                values[instruction.instruction_number] = wrap(static_cast<unsigned long long>(*larg) - static_cast<unsigned long long>(*rarg));
+                return true;
+            case Opcode::MUL:
+                if(!larg || !rarg) return false;
+                values[instruction.instruction_number] = wrap(static_cast<unsigned long long>(*larg) * static_cast<unsigned long long>(*rarg));
+                return true;
+            case Opcode::DIV:
+                // Traps are left for the program to hit at runtime.
+                if(!larg || !rarg || *rarg == 0 || (*larg == LLONG_MIN && *rarg == -1)) return false;
+                values[instruction.instruction_number] = *larg / *rarg;
+                return true;
+            case Opcode::SETPAR:
+                if(!larg) return false;
+                parameters.emplace_back(*larg);
+                return true;
+            case Opcode::GETPAR:
+                if(parameters.empty()) return false;
+                values[instruction.instruction_number] = parameters.back();
+                parameters.pop_back();
+                return true;
+            case Opcode::JSR: {
+                auto callee = labels.find(instruction.larg);
+                if(callee == labels.end()) return false;
+                const std::optional<long long> result = execute(callee->second);
+                if(!result) return false;
+                values[instruction.instruction_number] = *result;
+                return true;
+            }
+            case Opcode::WRITE: {
+                if(!writes || !larg) return false;
+                const std::string number = std::to_string(*larg);
+                if(output.size() + number.size() > output_budget) return false;
+                output += number;
+                return true;
+            }
+            case Opcode::WRITENL:
+                if(!writes || output.size() == output_budget) return false;
+                output += '\n';
+                return true;
+            case Opcode::CMP: // Its branch does the comparing.
+            case Opcode::EMPTY:
+                return true;
+            default:
+                return false;
+        }
+    };
+
+    std::optional<long long> result;
+    bb_t from = -1;
+    for(bb_t b = entry; b != -1 && fuel > 0;) {
+        --fuel;
+        const BasicBlock& block = basic_blocks[b];
+        auto instruction = block.instructions.begin();
+        // Phi functions take their values all at once, from the edge control came along.
+        std::vector<std::pair<instruct_t, long long>> phis;
+        for(; instruction != block.instructions.end() && instruction->opcode == Opcode::PHI; ++instruction) {
+            const bool right = block.branch_block != -1 ? from == block.branch_block : block.predecessors.size() > 1 && from == block.predecessors[1];
+            const std::optional<long long> argument = value(values, right ? instruction->rarg : instruction->larg);
+            if(!argument) break;
+            phis.emplace_back(instruction->instruction_number, *argument);
+        }
+        if(instruction != block.instructions.end() && instruction->opcode == Opcode::PHI) break;
+        for(const auto& [phi, argument] : phis) values[phi] = argument;
+        if(depth == 1 && checkpoints && (*checkpoints)[b] && parameters.empty()) checkpoint = Checkpoint{ b, output.size(), values };
+
+        for(; instruction != block.instructions.end(); ++instruction) {
+            if(fuel == 0 || !run_instruction(*instruction)) break;
+            --fuel;
+        }
+        if(instruction != block.instructions.end()) break;
+
+        const Instruction& branch_instruction = block.branch_instruction;
+        if(branch_instruction.opcode == Opcode::RET) {
+            result = branch_instruction.larg == -1 ? 0 : value(values, branch_instruction.larg);
+            break;
+        }
+        if(branch_instruction.opcode == Opcode::END || (branch_instruction.opcode == Opcode::EMPTY && block.successors.empty())) {
+            // The main function ends by falling off its last block.
+            result = 0;
+            break;
+        }
+        from = b;
+        b = next_block(b, values);
+    }
+    --depth;
+    return result;
+}
+
+std::optional<long long> Interpreter::value(const std::unordered_map<instruct_t, long long>& values, const instruct_t& instruct) const {
+    if(auto constant = const_instructions.find(instruct); constant != const_instructions.end()) return constant->second;
+    auto it = values.find(instruct);
+    if(it == values.end()) return std::nullopt;
+    return it->second;
+}
+
+bb_t Interpreter::next_block(const bb_t& b, const std::unordered_map<instruct_t, long long>& values) const {
+    const BasicBlock& block = basic_blocks[b];
+    const Instruction& branch_instruction = block.branch_instruction;
+    auto target = [&](const instruct_t& label) {
+        auto it = labels.find(label);
+        return it == labels.end() ? -1 : it->second;
+    };
+    switch(branch_instruction.opcode) {
+        case Opcode::EMPTY:
+            return block.successors.size() == 1 ? block.successors.front() : -1;
+        case Opcode::BRA:
+            return target(branch_instruction.larg);
+        default:
+            break;
+    }
+
+    if(branch_instruction.larg < 0 || branch_instruction.larg >= static_cast<instruct_t>(definitions.size()) || !definitions[branch_instruction.larg]) return -1;
+    const Instruction& cmp = *definitions[branch_instruction.larg];
+    const std::optional<long long> larg = value(values, cmp.larg);
+    const std::optional<long long> rarg = value(values, cmp.rarg);
+    if(!larg || !rarg) return -1;
+    bool taken;
+    switch(branch_instruction.opcode) {
+        case Opcode::BNE: taken = *larg != *rarg; break;
+        case Opcode::BEQ: taken = *larg == *rarg; break;
+        case Opcode::BLE: taken = *larg <= *rarg; break;
+        case Opcode::BLT: taken = *larg < *rarg; break;
+        case Opcode::BGE: taken = *larg >= *rarg; break;
+        case Opcode::BGT: taken = *larg > *rarg; break;
+        default: return -1;
+    }
+    const bb_t branch_target = target(branch_instruction.rarg);
+    if(taken) return branch_target;
+    for(const bb_t& successor : block.successors) {
+        if(successor != branch_target) return successor;
+    }
+    return -1;
+}
@@ -0,0 +1,97 @@
+#include "loopforest.hpp"
+#include <algorithm>
+#include <unordered_set>
+
+LoopForest::LoopForest(const std::pmr::vector<BasicBlock>& basic_blocks) : block_loops(basic_blocks.size(), -1) {
+    // Nested loop headers are created after the headers of the loops containing them,
+    // so visiting headers in index order puts parents before their children.
+    for(const BasicBlock& block : basic_blocks) {
+        if(block.branch_block == -1) continue;
+        Loop loop;
+        loop.header = block.index;
+        loop.branch_back = block.branch_block;
+        const bb_t entry = block.predecessors.front();
+        loop.preheader = basic_blocks[entry].successors.size() == 1 ? entry : -1;
+        loop.blocks = natural_loop(basic_blocks, block.index);
+        loops.emplace_back(std::move(loop));
+    }
+
+    // Innermost loops first: a block belongs to the first loop found containing it, and
+    // a loop's parent is the first loop found containing its header.
+    std::vector<loop_t> header_loops(basic_blocks.size(), -1);
+    for(loop_t l = loops.size() - 1; l >= 0; --l) {
+        header_loops[loops[l].header] = l;
+        for(const bb_t& b : loops[l].blocks) {
+            if(block_loops[b] == -1) block_loops[b] = l;
+            if(b == loops[l].header || header_loops[b] == -1) continue;
+            Loop& nested = loops[header_loops[b]];
+            if(nested.parent == -1) nested.parent = l;
+        }
+    }
+
+    for(loop_t l = 0; l < static_cast<loop_t>(loops.size()); ++l) {
+        Loop& loop = loops[l];
+        if(loop.parent == -1) {
+            top_level_loops.emplace_back(l);
+        } else {
+            loop.depth = loops[loop.parent].depth + 1;
+            loops[loop.parent].children.emplace_back(l);
+        }
+    }
+
+    for(loop_t l = 0; l < static_cast<loop_t>(loops.size()); ++l) {
+        for(const bb_t& b : loops[l].blocks) {
+            for(const bb_t& successor : basic_blocks[b].successors) {
+                if(contains(l, successor) || std::ranges::find(loops[l].exits, successor) != loops[l].exits.end()) continue;
+                loops[l].exits.emplace_back(successor);
+            }
+        }
+    }
+}
+
+std::vector<bb_t> LoopForest::natural_loop(const std::pmr::vector<BasicBlock>& basic_blocks, const bb_t& loop_header) {
+    // Back edges aren't recorded as predecessors, so a nested loop header's branch back
+    // block is walked to as if it were one of its predecessors.
+    std::unordered_set<bb_t> visited{ loop_header };
+    std::vector<bb_t> worklist{ basic_blocks[loop_header].branch_block };
+    while(!worklist.empty()) {
+        const bb_t b = worklist.back();
+        worklist.pop_back();
+        if(!visited.insert(b).second) continue;
+        for(const bb_t& predecessor : basic_blocks[b].predecessors) worklist.emplace_back(predecessor);
+        if(basic_blocks[b].branch_block != -1) worklist.emplace_back(basic_blocks[b].branch_block);
+    }
+    std::vector<bb_t> loop(visited.begin(), visited.end());
+    std::ranges::sort(loop);
+    return loop;
+}
+
+loop_t LoopForest::get_loop(const bb_t& b) const {
+    return block_loops.at(b);
+}
+
+size_t LoopForest::get_loop_depth(const bb_t& b) const {
+    const loop_t loop = block_loops.at(b);
+    return loop == -1 ? 0 : loops[loop].depth;
+}
+
+bool LoopForest::contains(const loop_t& loop, const bb_t& b) const {
+    for(loop_t l = block_loops.at(b); l != -1; l = loops[l].parent) {
+        if(l == loop) return true;
+        // Parents are never deeper than their children, so the given loop can't be further up.
+        if(loops[l].depth <= loops[loop].depth) return false;
+    }
+    return false;
+}
+
+const Loop& LoopForest::get(const loop_t& loop) const {
+    return loops.at(loop);
+}
+
+const std::vector<Loop>& LoopForest::get_loops() const {
+    return loops;
+}
+
+const std::vector<loop_t>& LoopForest::get_top_level_loops() const {
+    return top_level_loops;
+}
@@ -15,7 +15,7 @@ void Parser::print() {
 }
 
 IntermediateRepresentation Parser::release_ir() {
-    return ir;
+    return std::move(ir);
 }
 
 /* Parsing main function of Tiny program */
@@ -29,6 +29,18 @@ void Parser::computation() {
     match(Terminal::RBRACE);
     match(Terminal::PERIOD);
     lexer.check_all_defined();
+    ir.finish_construction();
+    ir.eliminate_tail_calls();
+    ir.inline_calls();
+    ir.propagate_constants();
+    ir.specialize_functions();
+    ir.eliminate_redundant_calls();
+    ir.unroll_loops();
+    ir.reduce_strength();
+    ir.eliminate_dead_code();
+    ir.evaluate_closed_forms();
+    ir.evaluate_partially();
+    ir.eliminate_dead_code();
 }
 
 /* Declarations */
@@ -56,8 +68,8 @@ bb_t Parser::function_declaration() {
     // contains instruction numbers of the first instruction of previously defined functions.
     std::vector<instruct_t> func_first_instructs{};
 
-    // contains incomplete function calls (vector of tuple<block of instruction, index of instruction, string of function call)
-    // incomplete_func_calls: std::vector<std::tuple<bb_t, int, std::string>
+    // contains incomplete function calls (vector of tuple<block of instruction, number of instruction, string of function call)
+    // incomplete_func_calls: std::vector<std::tuple<bb_t, instruct_t, std::string>
     std::unordered_map<std::string, int> func_map{};
 
     while(token_is(lexer.token, Keyword::VOID, Keyword::FUNCTION)) {
@@ -136,6 +148,7 @@ instruct_t Parser::function_body(const std::vector<ident_t>& formal_params, cons
         ++index;
     }
     ir.change_ident_value(func_block, index, ir.first_instruction(func_block));
+    function_labels.emplace_back(ir.first_instruction(func_block));
 
     // Add GETPAR instructions (reversed since we're popping from a stack)
     for(const auto& param : formal_params | std::views::reverse) {
@@ -252,11 +265,13 @@ std::pair<instruct_t, ident_t> Parser::function_statement(const bb_t& curr_block
         }
         match(Terminal::RPAREN);
     }
-    instruct_t jump_location = ir.get_ident_value(curr_block, ident);
+    // A function's label never changes, so it's taken directly instead of through the (loop) values of its identifier.
+    const bool is_function = ident >= 0 && static_cast<size_t>(ident) < function_labels.size();
+    instruct_t jump_location = is_function && !ir.ignore ? function_labels[ident] : ir.get_ident_value(curr_block, ident);
     instruct_t instruct = ir.add_instruction(curr_block, Opcode::JSR, jump_location); 
-    if(jump_location == -1) {
+    if(jump_location == -1 && !ir.ignore) {
         std::cout << std::format("Warning! Function {} is called before it is declared, which is ill advised.", func_name) << std::endl;
-        incomplete_func_calls.emplace_back(curr_block, ir.get_instructions(curr_block).size() - 1, func_name);
+        incomplete_func_calls.emplace_back(curr_block, instruct, func_name);
     }
     return { instruct , -1 };
 }
@@ -300,6 +315,15 @@ bool Parser::if_statement(bb_t& curr_block) {
         ir.set_branch_location(curr_block, ir.first_instruction(og_else_block));
     }
 
+    // A constant condition only ever runs one of the blocks, so it alone decides whether the if returns.
+    if(result == Relation::FALSE) {
+        curr_block = then_block;
+        return ir.will_return(then_block);
+    } else if(result == Relation::TRUE) {
+        curr_block = else_block;
+        return ir.will_return(else_block);
+    }
+
     // If both blocks return, no need to continue.
     if(ir.will_return(then_block) && ir.will_return(else_block)) {
          ir.set_return(curr_block);
@@ -307,10 +331,10 @@ bool Parser::if_statement(bb_t& curr_block) {
     }
 
     // If one of the blocks returns, no need to join.
-    if(ir.will_return(then_block) || result == Relation::TRUE) {
+    if(ir.will_return(then_block)) {
          curr_block = else_block;
          return false;
-    } else if (ir.will_return(else_block) || result == Relation::FALSE) {
+    } else if (ir.will_return(else_block)) {
         curr_block = then_block;
         return false;
     }
@@ -350,14 +374,14 @@ bool Parser::while_statement(bb_t& curr_block) {
     ir.while_loop = prev_while_loop;
 
     if(result == Relation::FALSE) {
-        // ir.generate_phi(curr_block, while_block);
         ir.update_phi(curr_block, while_block);
         ir.set_branch_cond(while_block, Opcode::BRA, ir.first_instruction(curr_block));
-        if(!ir.while_loop) ir.commit_while(curr_block, curr_block, while_block, lexer.identifier_table); 
+        ir.commit_while(curr_block, while_block);
         curr_block = while_block;
         return true;  // Since we ARE NEVER branching to outside the while loop,
                       // We do want to ignore parsing past the while loop (thus, we return true).
     } else if(result == Relation::TRUE) {
+        ir.update_phi(curr_block, -1);
         return false; // Since we ARE branching immediately to outside the while loop,
                       // We don't want to ignore parsing (thus, we return false).
     }
@@ -370,10 +394,14 @@ bool Parser::while_statement(bb_t& curr_block) {
 
 void Parser::branch(bb_t& curr_block, const bb_t& while_block) {
     bb_t og_curr_block = curr_block;
-    // ir.generate_phi(og_curr_block, while_block);
     ir.update_phi(og_curr_block, while_block);
     ir.set_branch_cond(while_block, Opcode::BRA, ir.first_instruction(og_curr_block));
-    if(!ir.while_loop) ir.commit_while(curr_block, curr_block, while_block, lexer.identifier_table);
+    ir.commit_while(og_curr_block, while_block);
+    const bb_t join = ir.unswitch_loop(og_curr_block, while_block);
+    if(join != -1) {
+        curr_block = join;
+        return;
+    }
     curr_block = ir.new_block(curr_block, WHILE_BRANCH);
     ir.set_branch_location(og_curr_block, ir.first_instruction(curr_block));
 }
@@ -404,13 +432,13 @@ Relation Parser::relation(const bb_t& curr_block, const bool& while_statement) {
         return terminal_cmp(rel_op, ir.get_const_value(larg.first), ir.get_const_value(rarg.first)) ? Relation::TRUE : Relation::FALSE;
     }
 
-    // Non-nested if statement constant folding (non-literals, skip on true and false)
-    if(!while_statement && !ir.while_loop && ir.is_const_instruction(larg.first) && ir.is_const_instruction(rarg.first)) {
+    // If statement constant folding (non-literals, skip on true and false)
+    if(!while_statement && ir.is_const_instruction(larg.first) && ir.is_const_instruction(rarg.first)) {
         return terminal_cmp(rel_op, ir.get_const_value(larg.first), ir.get_const_value(rarg.first)) ? Relation::TRUE : Relation::FALSE;
     }
 
-    // Non-nested while statement constant folding (non-literals, skip only if false)
-    if(while_statement && !ir.while_loop && ir.is_const_instruction(larg.first) && ir.is_const_instruction(rarg.first) &&
+    // While statement constant folding (non-literals, skip only if false)
+    if(while_statement && ir.is_const_instruction(larg.first) && ir.is_const_instruction(rarg.first) &&
        terminal_cmp(rel_op, ir.get_const_value(larg.first), ir.get_const_value(rarg.first)) == true) {
         return Relation::TRUE;
     }
@@ -449,8 +477,7 @@ void Parser::operate(const bb_t& curr_block, std::pair<instruct_t, ident_t>& lar
     std::pair<instruct_t, ident_t> rarg = (this->*func)(curr_block);
 
     // Operation (either const folding or non-const)
-    if (ir.is_const_instruction(larg.first) && ir.is_const_instruction(rarg.first) &&
-         (!ir.while_loop || (ir.while_loop && larg.second == -1 && rarg.second == -1))) {
+    if (ir.is_const_instruction(larg.first) && ir.is_const_instruction(rarg.first)) {
         larg = { ir.add_instruction(const_block, Opcode::CONST, operation->second.second(ir.get_const_value(larg.first), ir.get_const_value(rarg.first))), -1 };
     } else {
         larg = { ir.add_instruction(curr_block, operation->second.first, larg, rarg), -1 };
@@ -10,7 +10,7 @@
 RegisterAllocator::RegisterAllocator(IntermediateRepresentation&& ir) : ir(std::move(ir)) {}
 
 IntermediateRepresentation RegisterAllocator::release_ir() {
-    return ir;
+    return std::move(ir);
 }
 
 void RegisterAllocator::allocate_registers() {
@@ -25,10 +25,9 @@ void RegisterAllocator::debug() const {
 
 /* Liveness Analysis */
 void RegisterAllocator::liveness_analysis() {
-    for(const auto& block : ir.get_basic_blocks()) {
-        if(ir.has_zero_successors(block.index)) {
-            analyze_block(block.index);
-        }
+    // Back edges aren't part of the CFG, so in postorder every block comes after all of its successors.
+    for(const bb_t& block : ir.get_cfg().get_postorder()) {
+        analyze_block(block);
     }
 }
 
@@ -66,21 +65,27 @@ void RegisterAllocator::analyze_block(const bb_t& block) {
         // }
     } 
     // Get liveness from loop header you're entering into for the first time
-    else if(ir.has_one_successor(block) && ir.is_loop_header(ir.get_successors(block).at(0))) {
-        get_phi_liveness(block, ir.get_instructions(ir.get_successors(block).at(0)), true);
+    else if(ir.has_one_successor(block) && ir.is_loop_header(ir.get_cfg().get_successors(block)[0])) {
+        get_phi_liveness(block, ir.get_instructions(ir.get_cfg().get_successors(block)[0]), true);
     }
     // Get liveness from JOIN block (as block branching to it)
     else if(ir.has_one_successor(block) && ir.has_branch_instruction(block)) {
-        get_phi_liveness(block, ir.get_instructions(ir.get_successors(block).at(0)), true);
+        get_phi_liveness(block, ir.get_instructions(ir.get_cfg().get_successors(block)[0]), true);
     } 
     // Get liveness from JOIN block (as block falling through to it)
     else if(ir.has_one_successor(block)) {
-        get_phi_liveness(block, ir.get_instructions(ir.get_successors(block).at(0)), false);
-    } 
-    
+        get_phi_liveness(block, ir.get_instructions(ir.get_cfg().get_successors(block)[0]), false);
+    }
+
+    // A returned value is used after every instruction of the block, so it is live through all of them.
+    // Only its left argument is used; the right one can be left over from a branch the block had before.
+    const Instruction& branch_instruction = ir.get_branch_instruction(block);
+    if(branch_instruction.opcode == Opcode::RET) {
+        check_argument_deaths(Instruction(branch_instruction.instruction_number, Opcode::RET, branch_instruction.larg, -1), block);
+    }
+
     // Determine points of death and liveness of SSA instructions at the beginning of the block.
     for(const auto& instruction : ir.get_instructions(block) | std::views::reverse) {
-        if(instruction.opcode == Opcode::DELETED) continue; 
         // When something is born, everything beyond this point will not have it as a living SSA instruction. 
         // Also check to see if it was alive before this - if it wasn't, it is considered dead code.
         if(!ir.is_live_instruction(block, instruction.instruction_number)) {
@@ -90,19 +95,19 @@ void RegisterAllocator::analyze_block(const bb_t& block) {
 
         // Ignore arguments of phi instructions since the move/swap calls will be in the predecessors.
         // Also ignore branch instructions as they don't require registers to work correctly in x86.
-        if(instruction.opcode == Opcode::PHI || non_reg_instruction(instruction)) {
-             continue;
+        if(has_trait(instruction.opcode, VALUE_OPERANDS)) {
+            // When something dies, everything beyond this point will have it as a living SSA instruction.
+            // An instruction is a candidate for death if:
+            // It is not invalid (ie doesn't exist or the special "0" instruction for undefined user identifiers)
+            // It is not a constant
+            // It is not alive at this point.
+            check_argument_deaths(instruction, block);
         }
 
-        // When something dies, everything beyond this point will have it as a living SSA instruction.
-        // An instruction is a candidate for death if:
-        // It is not invalid (ie doesn't exist or the special "0" instruction for undefined user identifiers)
-        // It is not a constant
-        // It is not alive at this point.
-        check_argument_deaths(instruction, block);
-
         // Apply constraints
-        apply_constraints(instruction, block);
+        if(has_trait(instruction.opcode, FIXED_REGISTER)) {
+            apply_constraints(instruction, block);
+        }
     }
 
     // This block has now been analyzed.
@@ -112,22 +117,18 @@ void RegisterAllocator::analyze_block(const bb_t& block) {
     if(ir.is_loop_header(block)) {
         propagate_death_deletions(block);
     }
-    
-    // Analyze predecessor blocks.
-    for(const auto& predecessor : ir.get_predecessors(block)) {
-        analyze_block(predecessor);
-    }
 }
 
 void RegisterAllocator::propagate_death_deletions(const bb_t& loop_header) {
-    delete_deaths(loop_header, ir.get_live_ins(loop_header));
-    const bb_t& fall_through = ir.get_block_type(ir.get_successors(loop_header).at(0)) == Blocktype::WHILE_FALLTHROUGH 
-                               ? ir.get_successors(loop_header).at(0) 
-                               : ir.get_successors(loop_header).at(1);
-    delete_deaths_loop(fall_through, ir.get_live_ins(loop_header));
+    // Everything live at the loop header stays alive throughout the loop's blocks.
+    const LoopForest& loop_forest = ir.get_loop_forest();
+    const std::pmr::unordered_set<instruct_t>& alives = ir.get_live_ins(loop_header);
+    for(const bb_t& block : loop_forest.get(loop_forest.get_loop(loop_header)).blocks) {
+        delete_deaths(block, alives);
+    }
 }
 
-void RegisterAllocator::delete_deaths(const bb_t& curr_block, const std::unordered_set<instruct_t>& alives) {
+void RegisterAllocator::delete_deaths(const bb_t& curr_block, const std::pmr::unordered_set<instruct_t>& alives) {
     ir.get_live_ins(curr_block).insert(alives.begin(), alives.end());
     for(const Instruction& instruction : ir.get_instructions(curr_block)) {
         for(const instruct_t& live_instruct : alives) {
@@ -137,18 +138,8 @@ void RegisterAllocator::delete_deaths(const bb_t& curr_block, const std::unorder
     }
 }
 
-void RegisterAllocator::delete_deaths_loop(const bb_t& curr_block, const std::unordered_set<instruct_t>& alives) {
-    delete_deaths(curr_block, alives);
-    if(ir.get_successors(curr_block).size() == 0) return;
-    delete_deaths_loop(ir.get_successors(curr_block).at(0), alives);
-    if(ir.get_successors(curr_block).size() == 2) {
-        delete_deaths_loop(ir.get_successors(curr_block).at(1), alives);
-    }
-}
-
-void RegisterAllocator::get_phi_liveness(const bb_t& block, const std::vector<Instruction>& instructions, const bool& left) {
+void RegisterAllocator::get_phi_liveness(const bb_t& block, const InstructionList& instructions, const bool& left) {
     for(const auto& instruction : instructions) {
-        if(instruction.opcode == Opcode::DELETED) continue;
         if(instruction.opcode != Opcode::PHI) break;
         if(left) {
             if(ir.is_const_instruction(instruction.larg)) continue;
@@ -160,18 +151,6 @@ void RegisterAllocator::get_phi_liveness(const bb_t& block, const std::vector<In
     }
 }
 
-bool RegisterAllocator::non_reg_instruction(const Instruction& instruction) {
-    return instruction.opcode == Opcode::BRA ||
-           instruction.opcode == Opcode::BNE ||
-           instruction.opcode == Opcode::BEQ ||
-           instruction.opcode == Opcode::BLE ||
-           instruction.opcode == Opcode::BLT ||
-           instruction.opcode == Opcode::BGE ||
-           instruction.opcode == Opcode::BGT ||
-           instruction.opcode == Opcode::JSR ||
-           instruction.opcode == Opcode::EMPTY; 
-}
-
 void RegisterAllocator::check_argument_deaths(const Instruction& instruction, const bb_t& block) {
     if(ir.is_valid_instruction(instruction.larg) && !ir.is_const_instruction(instruction.larg) && !ir.is_live_instruction(block, instruction.larg)) {
         ir.insert_live_in(block, instruction.larg);
@@ -194,9 +173,6 @@ void RegisterAllocator::apply_constraints(const Instruction& instruction, const
         case Opcode::RET:
             ir.constrain(instruction.instruction_number, block, RAX, true);
             break;
-        case Opcode::JSR:
-            ir.constrain(instruction.instruction_number, block, RAX, true);
-            break;
         default:
             break;
     }
@@ -207,9 +183,11 @@ void RegisterAllocator::color_ir() {
     // No need to color the const block.
     ir.set_colored(0);
 
-    // Color every function in the program (including main).
-    for(const auto& start_block : ir.get_successors(0)) {
-        color_block(start_block);
+    // Color every function in the program (including main). A depth first preorder visits
+    // a block's immediate dominator before the block itself.
+    for(const bb_t& block : ir.get_cfg().get_preorder()) {
+        if(block == 0) continue;
+        color_block(block);
     }
 }
 
@@ -234,7 +212,6 @@ void RegisterAllocator::color_block(const bb_t& block) {
     // instructions in the current block's predecessors and hence don't represent live 
     // instructions in the current block.
     for(const auto& instruction : ir.get_instructions(block)) {
-        if(instruction.opcode == Opcode::DELETED) continue;
         if(instruction.opcode != Opcode::PHI) break;
         ir.set_assigned_register(instruction.instruction_number, get_register(instruction, occupied));
         ir.prefer(instruction.instruction_number, ir.get_assigned_register(instruction.instruction_number), true);
@@ -243,7 +220,7 @@ void RegisterAllocator::color_block(const bb_t& block) {
 
     // Assign registers
     for(const auto& instruction : ir.get_instructions(block)) {
-        if(instruction.opcode == Opcode::DELETED || instruction.opcode == Opcode::PHI || instruction.opcode == Opcode::EMPTY) continue;
+        if(instruction.opcode == Opcode::PHI || instruction.opcode == Opcode::EMPTY) continue;
 
         // Unoccupy registers from dead SSA instructions
         if(ir.is_valid_instruction(instruction.larg) && ir.has_death_point(instruction.larg, instruction.instruction_number)) {
@@ -254,22 +231,7 @@ void RegisterAllocator::color_block(const bb_t& block) {
         }
 
         // The following instructions do not need to be assigned a register
-        if(instruction.opcode == Opcode::SETPAR ||
-           instruction.opcode == Opcode::CMP ||
-           instruction.opcode == Opcode::MOV ||
-           instruction.opcode == Opcode::SWAP ||
-           instruction.opcode == Opcode::WRITE ||
-           instruction.opcode == Opcode::WRITENL ||
-           instruction.opcode == Opcode::BRA ||
-           instruction.opcode == Opcode::BNE ||
-           instruction.opcode == Opcode::BEQ ||
-           instruction.opcode == Opcode::BLE ||
-           instruction.opcode == Opcode::BLT ||
-           instruction.opcode == Opcode::BGE ||
-           instruction.opcode == Opcode::BGT ||
-           instruction.opcode == Opcode::EMPTY) {
-             continue;
-        }
+        if(!has_trait(instruction.opcode, HAS_RESULT)) continue;
 
         // Assign oneself a register
         ir.set_assigned_register(instruction.instruction_number, get_register(instruction, occupied));
@@ -286,21 +248,16 @@ void RegisterAllocator::color_block(const bb_t& block) {
     if(ir.is_branch_back(block)) { // current block is a branch-back block
         implement_phi_copies(block, ir.get_loop_header(block));
     }
-    for(const auto& predecessor : ir.get_predecessors(block)) {
+    for(const bb_t& predecessor : ir.get_cfg().get_predecessors(block)) {
         if(ir.is_colored(predecessor)) {
             implement_phi_copies(predecessor, block);
         }
     }
-    for(const auto& successor: ir.get_successors(block)) {
+    for(const bb_t& successor : ir.get_cfg().get_successors(block)) {
         if(ir.is_colored(successor)) {
             implement_phi_copies(block, successor);
         }
     }
-
-    // Color successors
-    for(const auto& successor : ir.get_successors(block)) {
-        color_block(successor);
-    }
 }
 
 void RegisterAllocator::implement_phi_copies(const bb_t& block, const bb_t& phi_block) {
@@ -323,7 +280,7 @@ void RegisterAllocator::implement_phi_copies(const bb_t& block, const bb_t& phi_
         insert_phi_copies(block, phi_block, false);
     } 
     // While loop header (phi_block) and block above it (block)
-    else if(ir.is_loop_header(phi_block) && ir.has_one_successor(block) && ir.get_successors(block).at(0) == phi_block) {
+    else if(ir.is_loop_header(phi_block) && ir.has_one_successor(block) && ir.get_cfg().get_successors(block)[0] == phi_block) {
         insert_phi_copies(block, phi_block, true);
     }
     // Join block (phi_block) and block branching to it (block)
@@ -370,7 +327,6 @@ void RegisterAllocator::insert_phi_copies(const bb_t& block, const bb_t& phi_blo
     std::map<instruct_t, instruct_t> mov_instructs;
     std::vector<std::pair<instruct_t, instruct_t>> const_movs;
     for(const auto& instruction : ir.get_instructions(phi_block)) {
-        if(instruction.opcode == Opcode::DELETED) continue;
         if(instruction.opcode != Opcode::PHI) break;
         if(left) {
             if(ir.is_const_instruction(instruction.larg)) { 
@@ -0,0 +1,86 @@
+#include "scalarevolution.hpp"
+#include <algorithm>
+
+ScalarEvolution::ScalarEvolution(const std::pmr::vector<BasicBlock>& basic_blocks, const std::pmr::unordered_map<instruct_t, int>& const_instructions, const Loop& loop)
+    : variables(basic_blocks, const_instructions, loop) {
+    // The loop must do nothing but compute its phi functions' values, and only leave through its header.
+    if(!loop.children.empty() || loop.exits.size() != 1) return;
+    if(std::ranges::find(basic_blocks[loop.header].successors, loop.exits.front()) == basic_blocks[loop.header].successors.end()) return;
+    std::unordered_map<instruct_t, const Instruction*> definitions;
+    for(const bb_t& b : loop.blocks) {
+        for(const Instruction& instruction : basic_blocks[b].instructions) {
+            if(has_trait(instruction.opcode, HAS_SIDE_EFFECTS)) return;
+            definitions[instruction.instruction_number] = &instruction;
+        }
+        const Opcode& op = basic_blocks[b].branch_instruction.opcode;
+        if(op == Opcode::RET || op == Opcode::END) return;
+    }
+    auto find_variable = [&](const instruct_t& instruct) -> std::pair<ssize_t, bool> {
+        for(size_t i = 0; i < variables.get_basic().size(); ++i) {
+            if(variables.get_basic()[i].phi == instruct) return { i, false };
+            if(variables.get_basic()[i].increment == instruct) return { i, true };
+        }
+        return { -1, false };
+    };
+
+    // The loop keeps going while its header's branch isn't taken.
+    const Instruction& branch_instruction = basic_blocks[loop.header].branch_instruction;
+    auto cmp = definitions.find(branch_instruction.larg);
+    if(cmp == definitions.end() || cmp->second->opcode != Opcode::CMP) return;
+    bool below; // The variable stays below the bound (it's stepping up), or above it.
+    bool inclusive;
+    switch(branch_instruction.opcode) {
+        case Opcode::BGE: below = true; inclusive = false; break;
+        case Opcode::BGT: below = true; inclusive = true; break;
+        case Opcode::BLE: below = false; inclusive = false; break;
+        case Opcode::BLT: below = false; inclusive = true; break;
+        default: return;
+    }
+    auto [variable, incremented] = find_variable(cmp->second->larg);
+    instruct_t bound = cmp->second->rarg;
+    if(variable == -1 || incremented) {
+        // The bound is on the left, which flips the comparison.
+        std::tie(variable, incremented) = find_variable(cmp->second->rarg);
+        bound = cmp->second->larg;
+        below = !below;
+    }
+    if(variable == -1 || incremented || !variables.is_invariant(bound)) return;
+    const int& step = variables.get_basic()[variable].step;
+    if(below ? step <= 0 : step >= 0) return;
+
+    // Every phi function of the header is something plus (or minus) a loop-invariant value or a basic induction variable.
+    for(const Instruction& phi : basic_blocks[loop.header].instructions) {
+        if(phi.opcode != Opcode::PHI) break;
+        auto next = definitions.find(phi.rarg);
+        if(next == definitions.end()) return;
+        const Instruction& instruction = *next->second;
+        instruct_t addend;
+        if((instruction.opcode == Opcode::ADD || instruction.opcode == Opcode::SUB) && instruction.larg == phi.instruction_number) addend = instruction.rarg;
+        else if(instruction.opcode == Opcode::ADD && instruction.rarg == phi.instruction_number) addend = instruction.larg;
+        else return;
+
+        Recurrence recurrence{ phi.instruction_number, addend, instruction.opcode == Opcode::SUB };
+        if(!variables.is_invariant(addend)) {
+            std::tie(recurrence.variable, recurrence.incremented) = find_variable(addend);
+            if(recurrence.variable == -1 || variables.get_basic()[recurrence.variable].phi == phi.instruction_number) return;
+        }
+        recurrences.emplace_back(recurrence);
+    }
+    trip_count = TripCount{ static_cast<size_t>(variable), bound, inclusive };
+}
+
+bool ScalarEvolution::is_computable() const {
+    return trip_count.has_value();
+}
+
+const InductionVariables& ScalarEvolution::get_induction_variables() const {
+    return variables;
+}
+
+const std::vector<Recurrence>& ScalarEvolution::get_recurrences() const {
+    return recurrences;
+}
+
+const TripCount& ScalarEvolution::get_trip_count() const {
+    return trip_count.value();
+}
@@ -0,0 +1,71 @@
+#include "valuetable.hpp"
+#include <algorithm>
+#include <functional>
+#include <ranges>
+
+ValueKey::ValueKey(Opcode op, const instruct_t& x1, const instruct_t& x2) : opcode(op), larg(x1), rarg(x2) {
+    if(has_trait(op, IS_COMMUTATIVE) && rarg < larg) std::swap(larg, rarg);
+}
+
+size_t ValueKeyHash::operator()(const ValueKey& key) const {
+    size_t hash = std::hash<instruct_t>{}(key.larg);
+    hash ^= std::hash<instruct_t>{}(key.rarg) + 0x9e3779b97f4a7c15 + (hash << 6) + (hash >> 2);
+    hash ^= std::hash<int>{}(key.opcode) + 0x9e3779b97f4a7c15 + (hash << 6) + (hash >> 2);
+    return hash;
+}
+
+void ValueTable::enter_scope(const bb_t& b) {
+    scope_depths[b] = scopes.size();
+    scopes.emplace_back(b);
+    scope_keys.emplace_back();
+}
+
+void ValueTable::leave_scope() {
+    const size_t depth = scopes.size() - 1;
+    for(const ValueKey& key : scope_keys.back()) {
+        auto it = definitions.find(key);
+        // The definition may have already been erased.
+        if(it == definitions.end() || it->second.back().depth != depth) continue;
+        it->second.pop_back();
+        if(it->second.empty()) definitions.erase(it);
+    }
+    scope_depths.erase(scopes.back());
+    scopes.pop_back();
+    scope_keys.pop_back();
+}
+
+bb_t ValueTable::current_scope() const {
+    return scopes.back();
+}
+
+bool ValueTable::in_scope(const bb_t& b) const {
+    return scope_depths.find(b) != scope_depths.end();
+}
+
+instruct_t ValueTable::lookup(const bb_t& b, const ValueKey& key) const {
+    auto it = definitions.find(key);
+    if(it == definitions.end()) return -1;
+    // Definitions made deeper than the given block are not visible to it.
+    const size_t depth = scope_depths.at(b);
+    for(const Definition& definition : it->second | std::views::reverse) {
+        if(definition.depth <= depth) return definition.instruct;
+    }
+    return -1;
+}
+
+void ValueTable::insert(const bb_t& b, const ValueKey& key, const instruct_t& instruct) {
+    const size_t depth = scope_depths.at(b);
+    std::vector<Definition>& stack = definitions[key];
+    // Keep the stack ordered by depth so leaving a scope only ever pops the back.
+    auto position = std::find_if(stack.begin(), stack.end(), [&](const Definition& d) { return d.depth >= depth; });
+    if(position != stack.end() && position->depth == depth) return;
+    stack.insert(position, { instruct, depth });
+    scope_keys[depth].emplace_back(key);
+}
+
+void ValueTable::erase(const ValueKey& key, const instruct_t& instruct) {
+    auto it = definitions.find(key);
+    if(it == definitions.end()) return;
+    std::erase_if(it->second, [&](const Definition& d) { return d.instruct == instruct; });
+    if(it->second.empty()) definitions.erase(it);
+}
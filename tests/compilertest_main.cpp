@@ -3,9 +3,12 @@
 #include "assembler.hpp"
 #include "registerallocator.hpp"
 #include <cstring>
+#include <sys/resource.h>
 
-#define USAGE_MSG " INFILE [-d] [-o OUTFILE]"\
+#define USAGE_MSG " INFILE [-d] [-m] [-M] [-o OUTFILE]"\
                   "\n  -d          Debug information"\
+                  "\n  -m          Report the memory high-water mark after each stage"\
+                  "\n  -M          Memoize the results of pure recursive functions"\
                   "\n  -o          Output is written to OUTFILE if specified. If unspecified, output is written to INFILE with .s as the extension."\
 
 int main(int argc, char *argv[])
@@ -24,11 +27,19 @@ int main(int argc, char *argv[])
 
     // Go through flags
     bool debug = false;
+    bool memory_report = false;
+    bool memoize = false;
     bool output_name = false;
     for(int i = 2; i < argc; ++i) {
         if (strcmp(argv[i], "-d") == 0) {
             debug = true;
         }
+        if (strcmp(argv[i], "-m") == 0) {
+            memory_report = true;
+        }
+        if (strcmp(argv[i], "-M") == 0) {
+            memoize = true;
+        }
         if (strcmp(argv[i], "-o") == 0) {
             if(i + 1 == argc) {
                 std::cerr << argv[0] << USAGE_MSG << std::endl;
@@ -46,19 +57,35 @@ int main(int argc, char *argv[])
         return 1;
     }
 
+    // Peak resident set size of the process so far (ru_maxrss is in kilobytes on Linux)
+    auto report_memory = [&](const char* stage) {
+        if(!memory_report) return;
+        rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        std::cerr << stage << ": " << usage.ru_maxrss << " KB" << std::endl;
+    };
+
     /* Parse */
     Parser p{ stream };
     p.parse();
     if(debug) p.print();
+    report_memory("parse");
 
     /* Allocate Registers */
-    RegisterAllocator r{ p.release_ir() };
+    IntermediateRepresentation parsed = p.release_ir();
+    if(memoize) parsed.memoize_functions();
+    RegisterAllocator r{ std::move(parsed) };
     r.allocate_registers();
+    report_memory("register allocation");
 
     /* Emit Assembly */
-    CodeEmitter c { r.release_ir(), file_name };
+    IntermediateRepresentation ir = r.release_ir();
+    // Liveness and register preferences aren't needed past allocation (unless they're being printed)
+    if(!debug) ir.release_allocation_analyses();
+    CodeEmitter c { std::move(ir), file_name };
     c.emit_code();
     if(debug) c.debug();
+    report_memory("code emission");
     
 
     /* Generate ELF Binary */
@@ -67,6 +94,7 @@ int main(int argc, char *argv[])
     a.read_symbols();
     a.read_program();
     a.create_binary("my.out");
+    report_memory("assembly");
 
     return 0;
 }